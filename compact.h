@@ -0,0 +1,92 @@
+#ifndef _COMPACT_H_
+#define _COMPACT_H_
+
+#include <stdlib.h>
+#include <string.h>
+
+// A vector for plain data that's usually short: the first N elements live in
+// the object itself, and only a longer list goes out to the heap.  T must be
+// safe to copy with memcpy.
+template <class T, int N>
+class small_vector
+{
+ public:
+  small_vector() : data(local), len(0), cap(N) {}
+  small_vector(const small_vector &b) : data(local), len(0), cap(N) { *this = b; }
+  ~small_vector() { if (data != local) free(data); }
+
+  small_vector &operator=(const small_vector &b)
+  {
+   if (this != &b) {
+    reserve(b.len);
+    memcpy(data, b.data, b.len * sizeof(T));
+    len = b.len;
+   }
+   return *this;
+  }
+
+  int size() const { return len; }
+  bool empty() const { return len == 0; }
+  T &operator[](int i) { return data[i]; }
+  const T &operator[](int i) const { return data[i]; }
+
+  void push_back(const T &t)
+  {
+   if (len == cap)
+    reserve(cap * 2);
+   data[len++] = t;
+  }
+  void erase(int i)
+  {
+   memmove(data + i, data + i + 1, (len - i - 1) * sizeof(T));
+   len--;
+  }
+  void clear() { len = 0; }
+
+ private:
+  void reserve(int n)
+  {
+   if (n <= cap)
+    return;
+   T *grown = (T *)malloc(n * sizeof(T));
+   memcpy(grown, data, len * sizeof(T));
+   if (data != local)
+    free(data);
+   data = grown;
+   cap = n;
+  }
+
+  T local[N];
+  T *data;
+  int len, cap;
+};
+
+// Owns at most one T, made the first time it's asked for, for data that most
+// owners never need.  Copying the owner copies the T along with it.
+template <class T>
+class lazy_ptr
+{
+ public:
+  lazy_ptr() : p(NULL) {}
+  lazy_ptr(const lazy_ptr &b) : p(b.p ? new T(*b.p) : NULL) {}
+  ~lazy_ptr() { delete p; }
+
+  lazy_ptr &operator=(const lazy_ptr &b)
+  {
+   if (this != &b) {
+    T *copy = (b.p ? new T(*b.p) : NULL);
+    delete p;
+    p = copy;
+   }
+   return *this;
+  }
+
+  T *get() const { return p; } // NULL if it's never been made
+  T &make() { if (!p) p = new T(); return *p; }
+  void reset() { delete p; p = NULL; }
+
+ private:
+  T *p;
+};
+
+#endif
@@ -584,7 +584,7 @@ void game::complete_construction()
 // Make the terrain change
  int terx = u.activity.placement.x, tery = u.activity.placement.y;
  if (stage.terrain != t_null)
-  m.ter(terx, tery) = stage.terrain;
+  m.ter_set(terx, tery, stage.terrain);
 
 // Strip off the first stage in our list...
  u.activity.values.erase(u.activity.values.begin());
@@ -747,8 +747,8 @@ void construct::done_furniture(game *g, point p)
   break;
  }
 
- g->m.ter(x, y) = g->m.ter(p.x, p.y);
- g->m.ter(p.x, p.y) = t_floor;
+ g->m.ter_set(x, y, g->m.ter(p.x, p.y));
+ g->m.ter_set(p.x, p.y, t_floor);
 }
 
 void construct::done_tree(game *g, point p)
@@ -763,7 +763,7 @@ void construct::done_tree(game *g, point p)
  std::vector<point> tree = line_to(p.x, p.y, x, y, rng(1, 8));
  for (int i = 0; i < tree.size(); i++) {
   g->m.destroy(g, tree[i].x, tree[i].y, true);
-  g->m.ter(tree[i].x, tree[i].y) = t_log;
+  g->m.ter_set(tree[i].x, tree[i].y, t_log);
  }
 }
 
@@ -797,20 +797,20 @@ void construct::done_deconstruct(game *g, point p)
       g->m.add_item(p.x, p.y, g->itypes[itm_2x4], 0, 10);
       g->m.add_item(p.x, p.y, g->itypes[itm_rag], 0, 10);
       g->m.add_item(p.x, p.y, g->itypes[itm_nail], 0, rng(6,8));
-      g->m.ter(p.x, p.y) = t_floor;
+      g->m.ter_set(p.x, p.y, t_floor);
     break;
 
     case t_window_domestic:
       g->m.add_item(p.x, p.y, g->itypes[itm_stick], 0, 1);
       g->m.add_item(p.x, p.y, g->itypes[itm_curtain], 0, 2);
       g->m.add_item(p.x, p.y, g->itypes[itm_glass_sheet], 0, 1);
-      g->m.ter(p.x, p.y) = t_window_empty;
+      g->m.ter_set(p.x, p.y, t_window_empty);
     break;
 
     case t_backboard:
       g->m.add_item(p.x, p.y, g->itypes[itm_2x4], 0, 4);
       g->m.add_item(p.x, p.y, g->itypes[itm_nail], 0, rng(6,10));
-      g->m.ter(p.x, p.y) = t_pavement;
+      g->m.ter_set(p.x, p.y, t_pavement);
     break;
 
     case t_sandbox:
@@ -819,7 +819,7 @@ void construct::done_deconstruct(game *g, point p)
     case t_crate_c:
       g->m.add_item(p.x, p.y, g->itypes[itm_2x4], 0, 4);
       g->m.add_item(p.x, p.y, g->itypes[itm_nail], 0, rng(6,10));
-      g->m.ter(p.x, p.y) = t_floor;
+      g->m.ter_set(p.x, p.y, t_floor);
     break;
 
     case t_chair:
@@ -827,19 +827,19 @@ void construct::done_deconstruct(game *g, point p)
     case t_desk:
       g->m.add_item(p.x, p.y, g->itypes[itm_2x4], 0, 4);
       g->m.add_item(p.x, p.y, g->itypes[itm_nail], 0, rng(6,10));
-      g->m.ter(p.x, p.y) = t_floor;
+      g->m.ter_set(p.x, p.y, t_floor);
     break;
 
     case t_slide:
       g->m.add_item(p.x, p.y, g->itypes[itm_steel_plate], 0);
       g->m.add_item(p.x, p.y, g->itypes[itm_pipe], 0, rng(4,8));
-      g->m.ter(p.x, p.y) = t_grass;
+      g->m.ter_set(p.x, p.y, t_grass);
     break;
 
     case t_rack:
     case t_monkey_bars:
       g->m.add_item(p.x, p.y, g->itypes[itm_pipe], 0, rng(6,12));
-      g->m.ter(p.x, p.y) = t_grass;
+      g->m.ter_set(p.x, p.y, t_grass);
     break;
 
     case t_counter:
@@ -847,20 +847,20 @@ void construct::done_deconstruct(game *g, point p)
     case t_table:
       g->m.add_item(p.x, p.y, g->itypes[itm_2x4], 0, 6);
       g->m.add_item(p.x, p.y, g->itypes[itm_nail], 0, rng(6,8));
-      g->m.ter(p.x, p.y) = t_floor;
+      g->m.ter_set(p.x, p.y, t_floor);
     break;
 
     case t_pool_table:
       g->m.add_item(p.x, p.y, g->itypes[itm_2x4], 0, 4);
       g->m.add_item(p.x, p.y, g->itypes[itm_rag], 0, 4);
       g->m.add_item(p.x, p.y, g->itypes[itm_nail], 0, rng(6,10));
-      g->m.ter(p.x, p.y) = t_floor;
+      g->m.ter_set(p.x, p.y, t_floor);
     break;
 
     case t_bookcase:
       g->m.add_item(p.x, p.y, g->itypes[itm_2x4], 0, 12);
       g->m.add_item(p.x, p.y, g->itypes[itm_nail], 0, rng(12,16));
-      g->m.ter(p.x, p.y) = t_floor;
+      g->m.ter_set(p.x, p.y, t_floor);
     break;
   }
 
@@ -170,7 +170,10 @@ void defense_game::init_mtypes(game *g)
   g->mtypes[i]->flags.push_back(MF_SMELLS);
   g->mtypes[i]->flags.push_back(MF_HEARS);
   g->mtypes[i]->flags.push_back(MF_SEES);
+  g->mtypes[i]->set_bitmasks();
  }
+ for (int i = 0; i < num_moncats; i++)
+  g->moncat_tables[i] = moncat_picks(); // Spawn times have changed
 }
 
 void defense_game::init_constructions(game *g)
@@ -1,50 +1,117 @@
 #include "rng.h"
 #include "map.h"
 #include "game.h"
+#include "threadpool.h"
 
 #define INBOUNDS(x, y) \
  (x >= 0 && x < SEEX * my_MAPSIZE && y >= 0 && y < SEEY * my_MAPSIZE)
 
 bool vector_has(std::vector <item> vec, itype_id type);
 
+// Fields are copied as they stand, then worked out in three passes over the
+// submaps that have any, each shared out over the worker pool:
+//  fuel:   fires and acid eat the items on their own square
+//  spread: each field works out what it does, reading every other square's
+//          field from the copy
+//  age:    each field that was there at the start of the turn grows older,
+//          and may thin out or go away
+// A pass only changes the fields and items of its own submap, and its luck
+// comes from an rng_stream seeded by the turn and the square.  Anything that
+// reaches another square or the rest of the game is queued as a field_move
+// for move_fields(), which carries them out one at a time afterwards.  So a
+// turn comes out the same whichever order the submaps are done in.
 bool map::process_fields(game *g)
 {
- bool found_field = false;
- for (int x = 0; x < my_MAPSIZE; x++) {
-  for (int y = 0; y < my_MAPSIZE; y++) {
-   if (grid[x + y * my_MAPSIZE]->field_count > 0)
-    found_field |= process_fields_in_submap(g, x + y * my_MAPSIZE);
+ const int submaps = my_MAPSIZE * my_MAPSIZE;
+ field_turn = int(g->turn);
+ field_snapshot.resize(submaps * SEEX * SEEY);
+ field_snapshot_live.assign(submaps, false);
+ if (field_jobs.size() < submaps)
+  field_jobs.resize(submaps);
+ field_job_count = 0;
+ for (int n = 0; n < submaps; n++) {
+// Everything in the reality bubble is up to date as of now; see catch_up()
+  grid[n]->turn_last_touched = field_turn;
+  if (grid[n]->field_count <= 0)
+   continue;
+  field *snap = &field_snapshot[n * SEEX * SEEY];
+  for (int x = 0; x < SEEX; x++) {
+   for (int y = 0; y < SEEY; y++) {
+    snap[x * SEEY + y] = grid[n]->fld[x][y];
+    if (snap[x * SEEY + y].type != fd_null &&
+        (snap[x * SEEY + y].density > 3 || snap[x * SEEY + y].density < 1))
+     debugmsg("Whoooooa density of %d", snap[x * SEEY + y].density);
+   }
   }
+  field_snapshot_live[n] = true;
+  field_job &job = field_jobs[field_job_count++];
+  job.gridn = n;
+  memcpy(job.live, grid[n]->live_fields, sizeof(job.live));
+  job.moves.clear();
+ }
+ if (field_job_count == 0)
+  return false;
+// is_outside() would work these out on first use, from every thread at once
+ for (std::set<vehicle*>::iterator veh = vehicle_list.begin();
+      veh != vehicle_list.end(); ++veh) {
+  if ((*veh)->insides_dirty)
+   (*veh)->refresh_insides();
  }
- return found_field;
+ run_jobs(fields_fuel_job, this, field_job_count);
+ run_jobs(fields_spread_job, this, field_job_count);
+ run_jobs(fields_age_job, this, field_job_count);
+ move_fields(g);
+ return true;
+}
+
+field map::old_field_at(const int x, const int y)
+{
+ if (!INBOUNDS(x, y))
+  return field();
+ const int nonant = int(x / SEEX) + int(y / SEEY) * my_MAPSIZE;
+ if (!field_snapshot_live[nonant])
+  return field();
+ return field_snapshot[nonant * SEEX * SEEY + (x % SEEX) * SEEY + y % SEEY];
+}
+
+void map::fields_fuel_job(void *data, int index)
+{
+ map *m = (map *)data;
+ m->fields_fuel(m->field_jobs[index]);
+}
+
+void map::fields_spread_job(void *data, int index)
+{
+ map *m = (map *)data;
+ m->fields_spread(m->field_jobs[index]);
 }
 
-bool map::process_fields_in_submap(game *g, int gridn)
+void map::fields_age_job(void *data, int index)
 {
- bool found_field = false;
- field *cur;
- field_id curtype;
+ map *m = (map *)data;
+ m->fields_age(m->field_jobs[index]);
+}
+
+// Fires eat what's lying in them and the terrain under them, and grow on it;
+// acid eats away at items.  Only the square's own items are touched here, so
+// that the spread pass can look at its neighbours' once they're settled.
+void map::fields_fuel(field_job &job)
+{
+ const int gridn = job.gridn;
  for (int locx = 0; locx < SEEX; locx++) {
-  for (int locy = 0; locy < SEEY; locy++) {
-   cur = &(grid[gridn]->fld[locx][locy]);
-   int x = locx + SEEX * (gridn % my_MAPSIZE),
-       y = locy + SEEY * int(gridn / my_MAPSIZE);
-   
-   curtype = cur->type;
-   if (!found_field && curtype != fd_null)
-    found_field = true;
-   if (cur->density > 3 || cur->density < 1)
-    debugmsg("Whoooooa density of %d", cur->density);
-
-  if (cur->age == 0)	// Don't process "newborn" fields
-   curtype = fd_null;
-
-  int part;
-  vehicle *veh;
-  switch (curtype) {
-
-   case fd_null:
-    break;	// Do nothing, obviously.  OBVIOUSLY.
+  unsigned int live = job.live[locx];
+  for (int locy = 0; live != 0; locy++, live >>= 1) {
+   job.smoke[locx][locy] = 0;
+   if (!(live & 1))
+    continue;
+   field *cur = &(grid[gridn]->fld[locx][locy]);
+   if (cur->age == 0)	// Don't process "newborn" fields
+    continue;
+   const int x = locx + SEEX * (gridn % my_MAPSIZE),
+             y = locy + SEEY * int(gridn / my_MAPSIZE);
+   rng_stream luck(field_turn, x, y, 0);
+
+  switch (cur->type) {
 
    case fd_blood:
    case fd_bile:
@@ -61,7 +128,7 @@ bool map::process_fields_in_submap(game *g, int gridn)
          melting->made_of(FLESH)  || melting->made_of(POWDER)  ||
          melting->made_of(COTTON) || melting->made_of(WOOL)    ||
          melting->made_of(PAPER)  || melting->made_of(PLASTIC) ||
-         (melting->made_of(GLASS) && !one_in(3)) || one_in(4)) {
+         (melting->made_of(GLASS) && !luck.one_in(3)) || luck.one_in(4)) {
 // Acid destructable objects here
       melting->damage++;
       if (melting->damage >= 5 ||
@@ -76,9 +143,6 @@ bool map::process_fields_in_submap(game *g, int gridn)
     }
     break;
 
-   case fd_sap:
-    break; // It doesn't do anything.
-
    case fd_fire: {
 // Consume items as fuel to help us grow/last longer.
     bool destroyed = false;
@@ -128,7 +192,8 @@ bool map::process_fields_in_submap(game *g, int gridn)
       }
 
      } else if (it->made_of(FLESH)) {
-      if (vol <= cur->density * 5 || (cur->density == 3 && one_in(vol / 20))) {
+      if (vol <= cur->density * 5 ||
+          (cur->density == 3 && luck.one_in(vol / 20))) {
        cur->age--;
        destroyed = it->burn(cur->density);
        smoke += 3;
@@ -148,7 +213,7 @@ bool map::process_fields_in_submap(game *g, int gridn)
         smoke += 6;
         break;
        default:
-        cur->age += rng(80 * vol, 300 * vol);
+        cur->age += luck.rng(80 * vol, 300 * vol);
         smoke++;
       }
       destroyed = true;
@@ -161,9 +226,10 @@ bool map::process_fields_in_submap(game *g, int gridn)
 
      } else if (it->made_of(PLASTIC)) {
       smoke += 3;
-      if (it->burnt <= cur->density * 2 || (cur->density == 3 && one_in(vol))) {
+      if (it->burnt <= cur->density * 2 ||
+          (cur->density == 3 && luck.one_in(vol))) {
        destroyed = it->burn(cur->density);
-       if (one_in(vol + it->burnt))
+       if (luck.one_in(vol + it->burnt))
         cur->age--;
       }
      }
@@ -176,35 +242,37 @@ bool map::process_fields_in_submap(game *g, int gridn)
      }
     }
 
-    veh = veh_at(x, y, part);
-    if (veh)
-     veh->damage (part, cur->density * 10, false);
+    if (veh_at(x, y))
+     job.moves.push_back(field_move(x, y, x, y, move_scorch, fd_fire,
+                                    cur->density));
     // If the flames are in a brazier, they're fully contained, so skip consuming terrain
-    if(tr_brazier != tr_at(x, y)) {
+    if (!brazier_at(x, y)) {
      // Consume the terrain we're on
      if (has_flag(explodes, x, y)) {
-      ter(x, y) = ter_id(int(ter(x, y)) + 1);
+      job.moves.push_back(field_move(x, y, x, y, move_explode, fd_fire));
       cur->age = 0;
       cur->density = 3;
-      g->explosion(x, y, 40, 0, true);
 
-     } else if (has_flag(flammable, x, y) && one_in(32 - cur->density * 10)) {
+     } else if (has_flag(flammable, x, y) &&
+                luck.one_in(32 - cur->density * 10)) {
       cur->age -= cur->density * cur->density * 40;
       smoke += 15;
       if (cur->density == 3)
-       g->m.destroy(g, x, y, false);
+       job.moves.push_back(field_move(x, y, x, y, move_destroy, fd_fire));
 
-     } else if (has_flag(flammable2, x, y) && one_in(32 - cur->density * 10)) {
+     } else if (has_flag(flammable2, x, y) &&
+                luck.one_in(32 - cur->density * 10)) {
       cur->age -= cur->density * cur->density * 40;
       smoke += 15;
       if (cur->density == 3)
-       ter(x, y) = t_ash;
+       job.moves.push_back(field_move(x, y, x, y, move_ash, fd_fire));
 
-     } else if (has_flag(l_flammable, x, y) && one_in(62 - cur->density * 10)) {
+     } else if (has_flag(l_flammable, x, y) &&
+                luck.one_in(62 - cur->density * 10)) {
       cur->age -= cur->density * cur->density * 30;
       smoke += 10;
       if (cur->density == 3)
-       g->m.destroy(g, x, y, false);
+       job.moves.push_back(field_move(x, y, x, y, move_destroy, fd_fire));
 
      } else if (terlist[ter(x, y)].flags & mfb(swimmable))
       cur->age += 800;	// Flames die quickly on water
@@ -215,259 +283,153 @@ bool map::process_fields_in_submap(game *g, int gridn)
      cur->age += 300;
      cur->density++;
     }
+    job.smoke[locx][locy] = smoke;
+   } break;
 
+   default:
+    break;
+   }
+  }
+ }
+}
+
+// Everything else a field does.  Other squares' fields are read from the
+// copy in old_field_at(), never from the map, and anything done to them is
+// queued.
+void map::fields_spread(field_job &job)
+{
+ const int gridn = job.gridn;
+ for (int locx = 0; locx < SEEX; locx++) {
+  unsigned int live = job.live[locx];
+  for (int locy = 0; live != 0; locy++, live >>= 1) {
+   if (!(live & 1))
+    continue;
+   const int x = locx + SEEX * (gridn % my_MAPSIZE),
+             y = locy + SEEY * int(gridn / my_MAPSIZE);
+   if (field_snapshot[gridn * SEEX * SEEY + locx * SEEY + locy].age == 0)
+    continue;	// Don't process "newborn" fields
+   field *cur = &(grid[gridn]->fld[locx][locy]);
+   rng_stream luck(field_turn, x, y, 1);
+
+  switch (cur->type) {
+
+   case fd_fire: {
+    int smoke = job.smoke[locx][locy];
 // If the flames are in a pit, it can't spread to non-pit
     bool in_pit = (ter(x, y) == t_pit);
+    const bool brazier = brazier_at(x, y);
 // If the flames are REALLY big, they contribute to adjacent flames
-    if (cur->density == 3 && cur->age < 0 && tr_brazier != tr_at(x, y)) {
+    if (cur->density == 3 && cur->age < 0 && !brazier) {
 // Randomly offset our x/y shifts by 0-2, to randomly pick a square to spread to
-     int starti = rng(0, 2);
-     int startj = rng(0, 2);
+     int starti = luck.rng(0, 2);
+     int startj = luck.rng(0, 2);
      for (int i = 0; i < 3 && cur->age < 0; i++) {
       for (int j = 0; j < 3 && cur->age < 0; j++) {
        int fx = x + ((i + starti) % 3) - 1, fy = y + ((j + startj) % 3) - 1;
-       if (field_at(fx, fy).type == fd_fire && field_at(fx, fy).density < 3 &&
+       const field there = old_field_at(fx, fy);
+       if (there.type == fd_fire && there.density < 3 &&
            (in_pit == (ter(fx, fy) == t_pit))) {
-        field_at(fx, fy).density++; 
-        field_at(fx, fy).age = 0;
+        job.moves.push_back(field_move(x, y, fx, fy, move_flare, fd_fire));
         cur->age = 0;
        }
       }
      }
     }
 // Consume adjacent fuel / terrain / webs to spread.
+    int big_flames = 0;
+    bool nosmoke = true;
+    for (int ii = -1; ii <= 1; ii++) {
+     for (int jj = -1; jj <= 1; jj++) {
+      const field there = old_field_at(x+ii, y+jj);
+      if (there.type == fd_fire && there.density == 3)
+       big_flames++;
+      else if (there.type == fd_smoke)
+       nosmoke = false;
+     }
+    }
 // Randomly offset our x/y shifts by 0-2, to randomly pick a square to spread to
-    int starti = rng(0, 2);
-    int startj = rng(0, 2);
+    int starti = luck.rng(0, 2);
+    int startj = luck.rng(0, 2);
     for (int i = 0; i < 3; i++) {
      for (int j = 0; j < 3; j++) {
       int fx = x + ((i + starti) % 3) - 1, fy = y + ((j + startj) % 3) - 1;
       if (INBOUNDS(fx, fy)) {
+       const bool web = (old_field_at(fx, fy).type == fd_web);
        int spread_chance = 20 * (cur->density - 1) + 10 * smoke;
-       if (field_at(fx, fy).type == fd_web)
+       if (web)
         spread_chance = 50 + spread_chance / 2;
-       if (has_flag(explodes, fx, fy) && one_in(8 - cur->density) &&
-	   tr_brazier != tr_at(x, y)) {
-        ter(fx, fy) = ter_id(int(ter(fx, fy)) + 1);
-        g->explosion(fx, fy, 40, 0, true);
-       } else if ((i != 0 || j != 0) && rng(1, 100) < spread_chance &&
-                  tr_brazier != tr_at(x, y) &&
-                  (in_pit == (ter(fx, fy) == t_pit)) &&
+       if (has_flag(explodes, fx, fy) && luck.one_in(8 - cur->density) &&
+	   !brazier) {
+        job.moves.push_back(field_move(x, y, fx, fy, move_explode, fd_fire));
+       } else if ((i != 0 || j != 0) && luck.rng(1, 100) < spread_chance &&
+                  !brazier && (in_pit == (ter(fx, fy) == t_pit)) &&
                   ((cur->density == 3 &&
-                    (has_flag(flammable, fx, fy) || one_in(20))) ||
+                    (has_flag(flammable, fx, fy) || luck.one_in(20))) ||
                    (cur->density == 3 &&
-                    (has_flag(l_flammable, fx, fy) && one_in(10))) ||
-                   flammable_items_at(fx, fy) ||
-                   field_at(fx, fy).type == fd_web)) {
-        if (field_at(fx, fy).type == fd_smoke ||
-            field_at(fx, fy).type == fd_web)
-         field_at(fx, fy) = field(fd_fire, 1, 0);
-        else
-         add_field(g, fx, fy, fd_fire, 1);
+                    (has_flag(l_flammable, fx, fy) && luck.one_in(10))) ||
+                   flammable_items_at(fx, fy) || web)) {
+        job.moves.push_back(field_move(x, y, fx, fy, move_ignite, fd_fire));
        } else {
-        bool nosmoke = true;
-        for (int ii = -1; ii <= 1; ii++) {
-         for (int jj = -1; jj <= 1; jj++) {
-          if (field_at(x+ii, y+jj).type == fd_fire &&
-              field_at(x+ii, y+jj).density == 3)
-           smoke++;
-          else if (field_at(x+ii, y+jj).type == fd_smoke)
-           nosmoke = false;
-         }
-        }
+        smoke += big_flames;
 // If we're not spreading, maybe we'll stick out some smoke, huh?
         if (move_cost(fx, fy) > 0 &&
-            (!one_in(smoke) || (nosmoke && one_in(40))) && 
-            rng(3, 35) < cur->density * 10 && cur->age < 1000) {
+            (!luck.one_in(smoke) || (nosmoke && luck.one_in(40))) &&
+            luck.rng(3, 35) < cur->density * 10 && cur->age < 1000) {
          smoke--;
-         add_field(g, fx, fy, fd_smoke, rng(1, cur->density));
+         job.moves.push_back(field_move(x, y, fx, fy, move_smoke, fd_smoke,
+                                        luck.rng(1, cur->density)));
         }
        }
       }
      }
     }
    } break;
-  
+
    case fd_smoke:
-    for (int i = -1; i <= 1; i++) {
-     for (int j = -1; j <= 1; j++)
-      g->scent(x+i, y+j) = 0;
-    }
+    job.moves.push_back(field_move(x, y, x, y, move_unscent, cur->type));
     if (is_outside(x, y))
      cur->age += 50;
-    if (one_in(2)) {
-     std::vector <point> spread;
-     for (int a = -1; a <= 1; a++) {
-      for (int b = -1; b <= 1; b++) {
-       if ((field_at(x+a, y+b).type == fd_smoke &&
-             field_at(x+a, y+b).density < 3       ) ||
-           (field_at(x+a, y+b).is_null() && move_cost(x+a, y+b) > 0))
-        spread.push_back(point(x+a, y+b));
-      }
-     }
-     if (cur->density > 0 && cur->age > 0 && spread.size() > 0) {
-      point p = spread[rng(0, spread.size() - 1)];
-      if (field_at(p.x, p.y).type == fd_smoke &&
-          field_at(p.x, p.y).density < 3) {
-        field_at(p.x, p.y).density++;
-        cur->density--;
-      } else if (cur->density > 0 && move_cost(p.x, p.y) > 0 &&
-                 add_field(g, p.x, p.y, fd_smoke, 1)){
-       cur->density--;
-       field_at(p.x, p.y).age = cur->age;
-      }
-     }
-    }
+    spread_gas(job, luck, cur, x, y, 2);
    break;
 
    case fd_tear_gas:
 // Reset nearby scents to zero
-    for (int i = -1; i <= 1; i++) {
-     for (int j = -1; j <= 1; j++)
-      g->scent(x+i, y+j) = 0;
-    }
+    job.moves.push_back(field_move(x, y, x, y, move_unscent, cur->type));
     if (is_outside(x, y))
      cur->age += 30;
 // One in three chance that it spreads (less than smoke!)
-    if (one_in(3)) {
-     std::vector <point> spread;
-// Pick all eligible points to spread to
-     for (int a = -1; a <= 1; a++) {
-      for (int b = -1; b <= 1; b++) {
-       if (((field_at(x+a, y+b).type == fd_smoke ||
-             field_at(x+a, y+b).type == fd_tear_gas) &&
-             field_at(x+a, y+b).density < 3            )      ||
-           (field_at(x+a, y+b).is_null() && move_cost(x+a, y+b) > 0))
-        spread.push_back(point(x+a, y+b));
-      }
-     }
-// Then, spread to a nearby point
-     if (cur->density > 0 && cur->age > 0 && spread.size() > 0) {
-      point p = spread[rng(0, spread.size() - 1)];
-// Nearby teargas grows thicker
-      if (field_at(p.x, p.y).type == fd_tear_gas &&
-          field_at(p.x, p.y).density < 3) {
-        field_at(p.x, p.y).density++;
-        cur->density--;
-// Nearby smoke is converted into teargas
-      } else if (field_at(p.x, p.y).type == fd_smoke) {
-       field_at(p.x, p.y).type = fd_tear_gas;
-// Or, just create a new field.
-      } else if (cur->density > 0 && move_cost(p.x, p.y) > 0 &&
-                 add_field(g, p.x, p.y, fd_tear_gas, 1)) {
-       cur->density--;
-       field_at(p.x, p.y).age = cur->age;
-      }
-     }
-    }
+    spread_gas(job, luck, cur, x, y, 3);
     break;
 
    case fd_toxic_gas:
 // Reset nearby scents to zero
-    for (int i = -1; i <= 1; i++) {
-     for (int j = -1; j <= 1; j++)
-      g->scent(x+i, y+j) = 0;
-    }
+    job.moves.push_back(field_move(x, y, x, y, move_unscent, cur->type));
     if (is_outside(x, y))
      cur->age += 40;
-    if (one_in(2)) {
-     std::vector <point> spread;
-// Pick all eligible points to spread to
-     for (int a = -1; a <= 1; a++) {
-      for (int b = -1; b <= 1; b++) {
-       if (((field_at(x+a, y+b).type == fd_smoke ||
-             field_at(x+a, y+b).type == fd_tear_gas ||
-             field_at(x+a, y+b).type == fd_toxic_gas ||
-             field_at(x+a, y+b).type == fd_nuke_gas   ) &&
-             field_at(x+a, y+b).density < 3            )      ||
-           (field_at(x+a, y+b).is_null() && move_cost(x+a, y+b) > 0))
-        spread.push_back(point(x+a, y+b));
-      }
-     }
-// Then, spread to a nearby point
-     if (cur->density > 0 && cur->age > 0 && spread.size() > 0) {
-      point p = spread[rng(0, spread.size() - 1)];
-// Nearby toxic gas grows thicker
-      if (field_at(p.x, p.y).type == fd_toxic_gas &&
-          field_at(p.x, p.y).density < 3) {
-        field_at(p.x, p.y).density++;
-        cur->density--;
-// Nearby smoke & teargas is converted into toxic gas
-      } else if (field_at(p.x, p.y).type == fd_smoke ||
-                 field_at(p.x, p.y).type == fd_tear_gas) {
-       field_at(p.x, p.y).type = fd_toxic_gas;
-// Or, just create a new field.
-      } else if (cur->density > 0 && move_cost(p.x, p.y) > 0 &&
-                 add_field(g, p.x, p.y, fd_toxic_gas, 1)) {
-       cur->density--;
-       field_at(p.x, p.y).age = cur->age;
-      }
-     }
-    }
+    spread_gas(job, luck, cur, x, y, 2);
     break;
 
 
    case fd_nuke_gas:
 // Reset nearby scents to zero
-    for (int i = -1; i <= 1; i++) {
-     for (int j = -1; j <= 1; j++)
-      g->scent(x+i, y+j) = 0;
-    }
+    job.moves.push_back(field_move(x, y, x, y, move_unscent, cur->type));
     if (is_outside(x, y))
      cur->age += 40;
 // Increase long-term radiation in the land underneath
-    radiation(x, y) += rng(0, cur->density);
-    if (one_in(2)) {
-     std::vector <point> spread;
-// Pick all eligible points to spread to
-     for (int a = -1; a <= 1; a++) {
-      for (int b = -1; b <= 1; b++) {
-       if (((field_at(x+a, y+b).type == fd_smoke ||
-             field_at(x+a, y+b).type == fd_tear_gas ||
-             field_at(x+a, y+b).type == fd_toxic_gas ||
-             field_at(x+a, y+b).type == fd_nuke_gas   ) &&
-             field_at(x+a, y+b).density < 3            )      ||
-           (field_at(x+a, y+b).is_null() && move_cost(x+a, y+b) > 0))
-        spread.push_back(point(x+a, y+b));
-      }
-     }
-// Then, spread to a nearby point
-     if (cur->density > 0 && cur->age > 0 && spread.size() > 0) {
-      point p = spread[rng(0, spread.size() - 1)];
-// Nearby nukegas grows thicker
-      if (field_at(p.x, p.y).type == fd_nuke_gas &&
-          field_at(p.x, p.y).density < 3) {
-        field_at(p.x, p.y).density++;
-        cur->density--;
-// Nearby smoke, tear, and toxic gas is converted into nukegas
-      } else if (field_at(p.x, p.y).type == fd_smoke ||
-                 field_at(p.x, p.y).type == fd_toxic_gas ||
-                 field_at(p.x, p.y).type == fd_tear_gas) {
-       field_at(p.x, p.y).type = fd_nuke_gas;
-// Or, just create a new field.
-      } else if (cur->density > 0 && move_cost(p.x, p.y) > 0 &&
-                 add_field(g, p.x, p.y, fd_nuke_gas, 1)) {
-       cur->density--;
-       field_at(p.x, p.y).age = cur->age;
-      }
-     }
-    }
+    radiation(x, y) += luck.rng(0, cur->density);
+    spread_gas(job, luck, cur, x, y, 2);
     break;
 
    case fd_gas_vent:
     for (int i = x - 1; i <= x + 1; i++) {
-     for (int j = y - 1; j <= y + 1; j++) {
-      if (field_at(i, j).type == fd_toxic_gas && field_at(i, j).density < 3)
-       field_at(i, j).density++;
-      else
-       add_field(g, i, j, fd_toxic_gas, 3);
-     }
+     for (int j = y - 1; j <= y + 1; j++)
+      job.moves.push_back(field_move(x, y, i, j, move_vent, fd_toxic_gas, 3));
     }
     break;
 
    case fd_fire_vent:
     if (cur->density > 1) {
-     if (one_in(3))
+     if (luck.one_in(3))
       cur->density--;
     } else {
      cur->type = fd_flame_burst;
@@ -485,14 +447,21 @@ bool map::process_fields_in_submap(game *g, int gridn)
     break;
 
    case fd_electricity:
-    if (!one_in(5)) {	// 4 in 5 chance to spread
+    if (!luck.one_in(5)) {	// 4 in 5 chance to spread
      std::vector<point> valid;
      if (move_cost(x, y) == 0 && cur->density > 1) { // We're grounded
+// Sparks already sent count as taken, as they did when they landed at once
+      std::vector<point> sparked;
       int tries = 0;
       while (tries < 10 && cur->age < 50) {
-       int cx = x + rng(-1, 1), cy = y + rng(-1, 1);
-       if (move_cost(cx, cy) != 0 && field_at(cx, cy).is_null()) {
-        add_field(g, cx, cy, fd_electricity, 1);
+       int cx = x + luck.rng(-1, 1), cy = y + luck.rng(-1, 1);
+       bool taken = false;
+       for (int n = 0; n < sparked.size() && !taken; n++)
+        taken = (sparked[n].x == cx && sparked[n].y == cy);
+       if (!taken && move_cost(cx, cy) != 0 && old_field_at(cx, cy).is_null()) {
+        job.moves.push_back(field_move(x, y, cx, cy, move_spark,
+                                       fd_electricity, 1));
+        sparked.push_back(point(cx, cy));
         cur->density--;
         tries = 0;
        } else
@@ -502,22 +471,21 @@ bool map::process_fields_in_submap(game *g, int gridn)
       for (int a = -1; a <= 1; a++) {
        for (int b = -1; b <= 1; b++) {
         if (move_cost(x + a, y + b) == 0 && // Grounded tiles first
-            field_at(x + a, y + b).is_null())
+            old_field_at(x + a, y + b).is_null())
          valid.push_back(point(x + a, y + b));
        }
       }
       if (valid.size() == 0) {	// Spread to adjacent space, then
-       int px = x + rng(-1, 1), py = y + rng(-1, 1);
-       if (move_cost(px, py) > 0 && field_at(px, py).type == fd_electricity &&
-           field_at(px, py).density < 3)
-        field_at(px, py).density++;
-       else if (move_cost(px, py) > 0)
-        add_field(g, px, py, fd_electricity, 1);
+       int px = x + luck.rng(-1, 1), py = y + luck.rng(-1, 1);
+       if (move_cost(px, py) > 0)
+        job.moves.push_back(field_move(x, y, px, py, move_arc,
+                                       fd_electricity, 1));
        cur->density--;
       }
       while (valid.size() > 0 && cur->density > 0) {
-       int index = rng(0, valid.size() - 1);
-       add_field(g, valid[index].x, valid[index].y, fd_electricity, 1);
+       int index = luck.rng(0, valid.size() - 1);
+       job.moves.push_back(field_move(x, y, valid[index].x, valid[index].y,
+                                      move_spark, fd_electricity, 1));
        cur->density--;
        valid.erase(valid.begin() + index);
       }
@@ -526,92 +494,47 @@ bool map::process_fields_in_submap(game *g, int gridn)
     break;
 
    case fd_fatigue:
-    if (cur->density < 3 && int(g->turn) % 3600 == 0 && one_in(10))
+    if (cur->density < 3 && field_turn % 3600 == 0 && luck.one_in(10))
      cur->density++;
-    else if (cur->density == 3 && one_in(600)) { // Spawn nether creature!
-     mon_id type = mon_id(rng(mon_flying_polyp, mon_blank));
-     monster creature(g->mtypes[type]);
-     creature.spawn(x + rng(-3, 3), y + rng(-3, 3));
-     g->z.push_back(creature);
+    else if (cur->density == 3 && luck.one_in(600)) { // Spawn nether creature!
+     job.moves.push_back(field_move(x, y, x + luck.rng(-3, 3),
+                                    y + luck.rng(-3, 3), move_rift, cur->type));
     }
     break;
 
-   case fd_push_items: {
-    std::vector<item> *it = &(i_at(x, y));
-    for (int i = 0; i < it->size(); i++) {
-     if ((*it)[i].type->id != itm_rock || (*it)[i].bday >= int(g->turn) - 1)
-      i++;
-     else {
-      item tmp = (*it)[i];
-      tmp.bday = int(g->turn);
-      it->erase(it->begin() + i);
-      i--;
-      std::vector<point> valid;
-      for (int xx = x - 1; xx <= x + 1; xx++) {
-       for (int yy = y - 1; yy <= y + 1; yy++) {
-        if (field_at(xx, yy).type == fd_push_items)
-         valid.push_back( point(xx, yy) );
-       }
-      }
-      if (!valid.empty()) {
-       point newp = valid[rng(0, valid.size() - 1)];
-       add_item(newp.x, newp.y, tmp);
-       if (g->u.posx == newp.x && g->u.posy == newp.y) {
-        g->add_msg("A %s hits you!", tmp.tname().c_str());
-        g->u.hit(g, random_body_part(), rng(0, 1), 6, 0);
-       }
-       int npcdex = g->npc_at(newp.x, newp.y),
-           mondex = g->mon_at(newp.x, newp.y);
-
-       if (npcdex != -1) {
-        int junk;
-        npc *p = &(g->active_npc[npcdex]);
-        p->hit(g, random_body_part(), rng(0, 1), 6, 0);
-        if (g->u_see(newp.x, newp.y, junk))
-         g->add_msg("A %s hits %s!", tmp.tname().c_str(), p->name.c_str());
-       }
-
-       if (mondex != -1) {
-        int junk;
-        monster *mon = &(g->z[mondex]);
-        mon->hurt(6 - mon->armor_bash());
-        if (g->u_see(newp.x, newp.y, junk))
-         g->add_msg("A %s hits the %s!", tmp.tname().c_str(),
-                                         mon->name().c_str());
-       }
-      }
-     }
-    }
-   } break;
+   case fd_push_items:
+    job.moves.push_back(field_move(x, y, x, y, move_push, cur->type));
+    break;
 
    case fd_shock_vent:
     if (cur->density > 1) {
-     if (one_in(5))
+     if (luck.one_in(5))
       cur->density--;
     } else {
      cur->density = 3;
-     int num_bolts = rng(3, 6);
+     int num_bolts = luck.rng(3, 6);
      for (int i = 0; i < num_bolts; i++) {
       int xdir = 0, ydir = 0;
       while (xdir == 0 && ydir == 0) {
-       xdir = rng(-1, 1);
-       ydir = rng(-1, 1);
+       xdir = luck.rng(-1, 1);
+       ydir = luck.rng(-1, 1);
       }
-      int dist = rng(4, 12);
+      int dist = luck.rng(4, 12);
       int boltx = x, bolty = y;
       for (int n = 0; n < dist; n++) {
        boltx += xdir;
        bolty += ydir;
-       add_field(g, boltx, bolty, fd_electricity, rng(2, 3));
-       if (one_in(4)) {
+       job.moves.push_back(field_move(x, y, boltx, bolty, move_spark,
+                                      fd_electricity, luck.rng(2, 3)));
+       if (luck.one_in(4)) {
         if (xdir == 0)
-         xdir = rng(0, 1) * 2 - 1;
+         xdir = luck.rng(0, 1) * 2 - 1;
         else
          xdir = 0;
        }
-       if (one_in(4)) {
+       if (luck.one_in(4)) {
         if (ydir == 0)
-         ydir = rng(0, 1) * 2 - 1;
+         ydir = luck.rng(0, 1) * 2 - 1;
         else
          ydir = 0;
        }
@@ -630,35 +553,282 @@ bool map::process_fields_in_submap(game *g, int gridn)
      cur->density = 3;
      for (int i = x - 5; i <= x + 5; i++) {
       for (int j = y - 5; j <= y + 5; j++) {
-       if (field_at(i, j).type == fd_null || field_at(i, j).density == 0) {
-        int newdens = 3 - (rl_dist(x, y, i, j) / 2) + (one_in(3) ? 1 : 0);
+       const field there = old_field_at(i, j);
+       if (there.type == fd_null || there.density == 0) {
+        int newdens = 3 - (rl_dist(x, y, i, j) / 2) + (luck.one_in(3) ? 1 : 0);
         if (newdens > 3)
          newdens = 3;
         if (newdens > 0)
-         add_field(g, i, j, fd_acid, newdens);
+         job.moves.push_back(field_move(x, y, i, j, move_splash, fd_acid,
+                                        newdens));
        }
       }
      }
     }
     break;
 
-   } // switch (curtype)
-  
+   default:
+    break;
+   } // switch (cur->type)
+  }
+ }
+}
+
+// Every field that was there at the start of the turn, newborn or not, gets
+// older, and thins out with age as its halflife says.
+void map::fields_age(field_job &job)
+{
+ const int gridn = job.gridn;
+ for (int locx = 0; locx < SEEX; locx++) {
+  unsigned int live = job.live[locx];
+  for (int locy = 0; live != 0; locy++, live >>= 1) {
+   if (!(live & 1))
+    continue;
+   field *cur = &(grid[gridn]->fld[locx][locy]);
    cur->age++;
    if (fieldlist[cur->type].halflife > 0) {
+    rng_stream luck(field_turn, locx + SEEX * (gridn % my_MAPSIZE),
+                    locy + SEEY * int(gridn / my_MAPSIZE), 2);
     if (cur->age > 0 &&
-        dice(3, cur->age) > dice(3, fieldlist[cur->type].halflife)) {
+        luck.dice(3, cur->age) > luck.dice(3, fieldlist[cur->type].halflife)) {
      cur->age = 0;
      cur->density--;
     }
     if (cur->density <= 0) { // Totally dissapated.
      grid[gridn]->field_count--;
+     grid[gridn]->live_fields[locx] &= ~(1 << locy);
      grid[gridn]->fld[locx][locy] = field();
     }
    }
   }
  }
- return found_field;
+}
+
+// Which gases a gas thickens when it drifts into them, and which it takes
+// over.  Toxic gas can drift into nuke gas but does nothing to it.
+static bool gas_mixes_with(const field_id gas, const field_id other)
+{
+ switch (gas) {
+  case fd_smoke:     return other == fd_smoke;
+  case fd_tear_gas:  return other == fd_smoke || other == fd_tear_gas;
+  case fd_toxic_gas:
+  case fd_nuke_gas:  return other == fd_smoke || other == fd_tear_gas ||
+                            other == fd_toxic_gas || other == fd_nuke_gas;
+  default:           return false;
+ }
+}
+
+static bool gas_converts(const field_id gas, const field_id other)
+{
+ switch (gas) {
+  case fd_tear_gas:  return other == fd_smoke;
+  case fd_toxic_gas: return other == fd_smoke || other == fd_tear_gas;
+  case fd_nuke_gas:  return other == fd_smoke || other == fd_tear_gas ||
+                            other == fd_toxic_gas;
+  default:           return false;
+ }
+}
+
+// One time in chance, picks a neighbouring square for the gas at (x, y) to
+// drift into, judged by the fields there at the start of the turn.  Gas that
+// drifts this turn can't be carried further along, and where a cloud ends up
+// doesn't depend on which way the map is scanned.
+void map::spread_gas(field_job &job, rng_stream &luck, field *cur,
+                     const int x, const int y, const int chance)
+{
+ if (!luck.one_in(chance))
+  return;
+ std::vector <point> spread;
+// Pick all eligible points to spread to
+ for (int a = -1; a <= 1; a++) {
+  for (int b = -1; b <= 1; b++) {
+   field there = old_field_at(x+a, y+b);
+   if ((gas_mixes_with(cur->type, there.type) && there.density < 3) ||
+       (there.is_null() && move_cost(x+a, y+b) > 0))
+    spread.push_back(point(x+a, y+b));
+  }
+ }
+ if (cur->density > 0 && cur->age > 0 && spread.size() > 0) {
+  point p = spread[luck.rng(0, spread.size() - 1)];
+  job.moves.push_back(field_move(x, y, p.x, p.y, move_drift, cur->type));
+ }
+}
+
+// Carries out what the fields queued this turn, after they've all aged.
+// Each move is checked against how things stand now, since gas may have
+// thinned out and other fields may have got to the square first.  Going
+// through them submap by submap would let the first submaps take the free
+// squares first, so they're shuffled.
+void map::move_fields(game *g)
+{
+ field_moves.clear();
+ for (int n = 0; n < field_job_count; n++)
+  field_moves.insert(field_moves.end(), field_jobs[n].moves.begin(),
+                     field_jobs[n].moves.end());
+ for (int i = field_moves.size() - 1; i > 0; i--)
+  std::swap(field_moves[i], field_moves[rng(0, i)]);
+ for (int i = 0; i < field_moves.size(); i++) {
+  const field_move &mv = field_moves[i];
+  field &to = field_at(mv.tox, mv.toy);
+  switch (mv.what) {
+
+  case move_drift: {
+   field &from = field_at(mv.x, mv.y);
+   if (from.type != mv.type || from.density <= 0)
+    break;
+// Nearby gas of the same kind grows thicker
+   if (to.type == mv.type && to.density < 3) {
+    to.density++;
+    from.density--;
+// Weaker gases are taken over
+   } else if (gas_converts(mv.type, to.type)) {
+    to.type = mv.type;
+// Or, just create a new field.
+   } else if (move_cost(mv.tox, mv.toy) > 0 &&
+              add_field(g, mv.tox, mv.toy, mv.type, 1)) {
+    from.density--;
+    to.age = from.age;
+   }
+   if (from.density <= 0)
+    remove_field(mv.x, mv.y);
+  } break;
+
+// Really big flames make the smaller ones next to them burn higher
+  case move_flare:
+   if (to.type == fd_fire && to.density < 3) {
+    to.density++;
+    to.age = 0;
+   }
+   break;
+
+// Fire burns away smoke and webs as it takes their place
+  case move_ignite:
+   if (to.type == fd_smoke || to.type == fd_web) {
+    to = field(fd_fire, 1, 0);
+    add_light_emitter(mv.tox, mv.toy);
+   } else
+    add_field(g, mv.tox, mv.toy, fd_fire, 1);
+   break;
+
+  case move_smoke:
+   add_field(g, mv.tox, mv.toy, fd_smoke, mv.density);
+   break;
+
+  case move_vent:
+   if (to.type == fd_toxic_gas && to.density < 3)
+    to.density++;
+   else
+    add_field(g, mv.tox, mv.toy, fd_toxic_gas, mv.density);
+   break;
+
+  case move_unscent:
+   for (int i = -1; i <= 1; i++) {
+    for (int j = -1; j <= 1; j++)
+     g->scent(mv.x + i, mv.y + j) = 0;
+   }
+   break;
+
+  case move_scorch: {
+   int part;
+   vehicle *veh = veh_at(mv.x, mv.y, part);
+   if (veh)
+    veh->damage(part, mv.density * 10, false);
+  } break;
+
+// Another fire may have set it off already
+  case move_explode:
+   if (has_flag(explodes, mv.tox, mv.toy)) {
+    ter_set(mv.tox, mv.toy, ter_id(int(ter(mv.tox, mv.toy)) + 1));
+    g->explosion(mv.tox, mv.toy, 40, 0, true);
+   }
+   break;
+
+  case move_destroy:
+   destroy(g, mv.x, mv.y, false);
+   break;
+
+  case move_ash:
+   ter_set(mv.x, mv.y, t_ash);
+   break;
+
+  case move_spark:
+   add_field(g, mv.tox, mv.toy, fd_electricity, mv.density);
+   break;
+
+  case move_arc:
+   if (to.type == fd_electricity && to.density < 3)
+    to.density++;
+   else
+    add_field(g, mv.tox, mv.toy, fd_electricity, mv.density);
+   break;
+
+  case move_splash:
+   add_field(g, mv.tox, mv.toy, fd_acid, mv.density);
+   break;
+
+  case move_rift: {
+   mon_id type = mon_id(rng(mon_flying_polyp, mon_blank));
+   monster creature(g->mtypes[type]);
+   creature.spawn(mv.tox, mv.toy);
+   g->z.push_back(creature);
+  } break;
+
+  case move_push:
+   push_items(g, mv.x, mv.y);
+   break;
+  }
+ }
+}
+
+// Rocks lying in a push field are thrown into a neighbouring one, hitting
+// whoever is standing there
+void map::push_items(game *g, const int x, const int y)
+{
+ std::vector<item> *it = &(i_at(x, y));
+ for (int i = 0; i < it->size(); i++) {
+  if ((*it)[i].type->id != itm_rock || (*it)[i].bday >= int(g->turn) - 1)
+   i++;
+  else {
+   item tmp = (*it)[i];
+   tmp.bday = int(g->turn);
+   it->erase(it->begin() + i);
+   i--;
+   std::vector<point> valid;
+   for (int xx = x - 1; xx <= x + 1; xx++) {
+    for (int yy = y - 1; yy <= y + 1; yy++) {
+     if (field_at(xx, yy).type == fd_push_items)
+      valid.push_back( point(xx, yy) );
+    }
+   }
+   if (!valid.empty()) {
+    point newp = valid[rng(0, valid.size() - 1)];
+    add_item(newp.x, newp.y, tmp);
+    if (g->u.posx == newp.x && g->u.posy == newp.y) {
+     g->add_msg("A %s hits you!", tmp.tname().c_str());
+     g->u.hit(g, random_body_part(), rng(0, 1), 6, 0);
+    }
+    int npcdex = g->npc_at(newp.x, newp.y),
+        mondex = g->mon_at(newp.x, newp.y);
+
+    if (npcdex != -1) {
+     int junk;
+     npc *p = &(g->active_npc[npcdex]);
+     p->hit(g, random_body_part(), rng(0, 1), 6, 0);
+     if (g->u_see(newp.x, newp.y, junk))
+      g->add_msg("A %s hits %s!", tmp.tname().c_str(), p->name.c_str());
+    }
+
+    if (mondex != -1) {
+     int junk;
+     monster *mon = &(g->z[mondex]);
+     mon->hurt(6 - mon->armor_bash());
+     if (g->u_see(newp.x, newp.y, junk))
+      g->add_msg("A %s hits the %s!", tmp.tname().c_str(),
+                                      mon->name().c_str());
+    }
+   }
+  }
+ }
 }
 
 void map::step_in_field(int x, int y, game *g)
@@ -966,10 +1136,8 @@ void map::mon_in_field(int x, int y, game *g, monster *z)
        g->add_msg("The %s teleports into a %s, killing them both!",
                   z->name().c_str(), g->z[mon_hit].name().c_str());
       g->explode_mon(mon_hit);
-     } else {
-      z->posx = newposx;
-      z->posy = newposy;
-     }
+     } else
+      z->setpos(g, newposx, newposy);
     }
    }
    break;
@@ -10,9 +10,12 @@
 #include "options.h"
 #include "mapbuffer.h"
 #include "debug.h"
+#include "threadpool.h"
 
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <climits>
 #include <math.h>
 #include <unistd.h>
 #include <dirent.h>
@@ -107,10 +110,14 @@ void game::setup()
  monstairx = -1;
  monstairy = -1;
  monstairz = -1;
- last_target = -1;	// We haven't targeted any monsters yet
+ last_target = mon_handle();	// We haven't targeted any monsters yet
  curmes = 0;		// We haven't read any messages yet
  uquit = QUIT_NO;	// We haven't quit the game
  debugmon = false;	// We're not printing debug messages
+ monmap_size = -1;
+ clear_claims();
+ for (int i = 0; i < NUM_MLOD; i++)
+  mon_lod_count[i] = 0;
  no_npc = false;		// We're not suppressing NPC spawns
 
 // ... Unless data/no_npc.txt exists.
@@ -125,6 +132,7 @@ void game::setup()
 
  footsteps.clear();
  z.clear();
+ monmap_changed();
  coming_to_stairs.clear();
  active_npc.clear();
  factions.clear();
@@ -142,6 +150,7 @@ void game::setup()
   for (int j = 0; j < SEEX * MAPSIZE; j++)
    grscent[i][j] = 0;
  }
+ scent_column = 0;
  if (opening_screen()) {// Opening menu
 // Finally, draw the screen!
   refresh_all();
@@ -479,6 +488,7 @@ void game::start_game()
  turn = MINUTES(STARTING_MINUTES);// It's turn 0...
  run_mode = (OPTIONS[OPT_SAFEMODE] ? 1 : 0);
  mostseen = 0;	// ...and mostseen is 0, we haven't seen any monsters yet.
+ rng_stream::game_seed = rand();
 
 // Init some factions.
  if (!load_master())	// Master data record contains factions.
@@ -563,12 +573,9 @@ bool game::do_turn()
   write_msg();
 // Save the monsters before we die!
   for (int i = 0; i < z.size(); i++) {
-   if (z[i].spawnmapx != -1) {	// Static spawn, move them back there
-    tinymap tmp(&itypes, &mapitems, &traps);
-    tmp.load(this, z[i].spawnmapx, z[i].spawnmapy, false);
-    tmp.add_spawn(&(z[i]));
-    tmp.save(&cur_om, turn, z[i].spawnmapx, z[i].spawnmapy);
-   } else {	// Absorb them back into a group
+   if (z[i].spawnmapx != -1)	// Static spawn, move them back there
+    despawn(z[i], z[i].spawnmapx, z[i].spawnmapy);
+   else {	// Absorb them back into a group
     int group = valid_group((mon_id)(z[i].type->id), levx, levy);
     if (group != -1) {
      cur_om.zg[group].population++;
@@ -578,6 +585,7 @@ bool game::do_turn()
     }
    }
   }
+  flush_despawns();
   if (uquit == QUIT_DIED)
    popup_top("Game over! Press spacebar...");
   if (uquit == QUIT_DIED || uquit == QUIT_SUICIDE)
@@ -675,6 +683,8 @@ bool game::do_turn()
  m.process_fields(this);
  m.process_active_items(this);
  m.step_in_field(u.posx, u.posy, this);
+ m.build_seen_cache(u.posx, u.posy);
+ m.clear_target_fovs();
 
  monmove();
  update_stair_monsters();
@@ -1582,7 +1592,7 @@ input_ret game::get_input(int timeout_ms)
  return IR_GOOD;
 }
 
-int& game::scent(int x, int y)
+short& game::scent(int x, int y)
 {
  if (x < 0 || x >= SEEX * MAPSIZE || y < 0 || y >= SEEY * MAPSIZE) {
   nulscent = 0;
@@ -1593,52 +1603,113 @@ int& game::scent(int x, int y)
 
 void game::update_scent()
 {
- signed int newscent[SEEX * MAPSIZE][SEEY * MAPSIZE];
  if (!u.has_active_bionic(bio_scent_mask))
   grscent[u.posx][u.posy] = u.scent;
  else
   grscent[u.posx][u.posy] = 0;
-
- for (int x = u.posx - 18; x <= u.posx + 18; x++) {
-  for (int y = u.posy - 18; y <= u.posy + 18; y++) {
-   newscent[x][y] = 0;
-   if (m.move_cost(x, y) != 0 || m.has_flag(bashable, x, y)) {
-    int squares_used = 0;
-    for (int i = -1; i <= 1; i++) {
-     for (int j = -1; j <= 1; j++) {
-      if (grscent[x][y] <= grscent[x+i][y+j]) {
-       newscent[x][y] += grscent[x+i][y+j];
-       squares_used++;
-      }
-     }
-    }
-    newscent[x][y] /= (squares_used + 1);
-    if (m.field_at(x, y).type == fd_slime &&
-        newscent[x][y] < 10 * m.field_at(x, y).density)
-     newscent[x][y] = 10 * m.field_at(x, y).density;
-    if (newscent[x][y] > 10000) {
-     dbg(D_ERROR) << "game:update_scent: Wacky scent at " << x << ","
-                  << y << " (" << newscent[x][y] << ")";
-     debugmsg("Wacky scent at %d, %d (%d)", x, y, newscent[x][y]);
-     newscent[x][y] = 0; // Scent should never be higher
-    }
-   }
+// Every square spread this turn reads the scent as it stood before the
+// spreading started, so the window around the player and the columns further
+// out meet without seams, and can be spread in any order or all at once.
+ memcpy(oldscent, grscent, sizeof(grscent));
+ scent_jobs.clear();
+ scent_jobs.push_back(scent_rect(u.posx - SCENT_RADIUS, u.posy - SCENT_RADIUS,
+                                 u.posx + SCENT_RADIUS, u.posy + SCENT_RADIUS));
+
+// Further out, scent spreads over the whole reality bubble a few columns of
+// submaps at a time.  The option sets how many; a slower machine can spread
+// fewer, and far scent just spreads more slowly.  It's counted in columns
+// rather than time, so how scent spreads doesn't depend on the machine.
+ int columns = int(OPTIONS[OPT_SCENT_BUDGET]);
+ if (columns <= 0)
+  columns = SCENT_FAR_COLUMNS; // Options files older than the option don't set it
+ for (int n = 0; n < columns && n < MAPSIZE; n++) {
+  add_scent_column(scent_column);
+  scent_column = (scent_column + 1) % MAPSIZE;
+ }
+ run_jobs(diffuse_scent_job, this, scent_jobs.size());
+ for (int i = 0; i < scent_jobs.size(); i++) {
+  const scent_rect &r = scent_jobs[i];
+  if (r.wacky > 0) {
+   dbg(D_ERROR) << "game:update_scent: Wacky scent in " << r.wacky
+                << " squares between " << r.x1 << "," << r.y1 << " and "
+                << r.x2 << "," << r.y2;
+   debugmsg("Wacky scent in %d squares between %d, %d and %d, %d", r.wacky,
+            r.x1, r.y1, r.x2, r.y2);
   }
  }
- for (int x = u.posx - 18; x <= u.posx + 18; x++) {
-  for (int y = u.posy - 18; y <= u.posy + 18; y++)
-   if(m.move_cost(x, y) == 0)
-    //Greatly reduce scent for bashable barriers
-    grscent[x][y] = newscent[x][y] / 4;
-   else
-    grscent[x][y] = newscent[x][y];
- }
  if (!u.has_active_bionic(bio_scent_mask))
   grscent[u.posx][u.posy] = u.scent;
  else
   grscent[u.posx][u.posy] = 0;
 }
 
+// Adds one column of submaps to this turn's scent_jobs, leaving out the
+// squares around the player, which are always spread
+void game::add_scent_column(const int column)
+{
+ // Stay clear of the edge of the map, where the stencil would run off it
+ const int x1 = std::max(column * SEEX, 1);
+ const int x2 = std::min((column + 1) * SEEX - 1, SEEX * MAPSIZE - 2);
+ const int last_y = SEEY * MAPSIZE - 2;
+ const int nx1 = u.posx - SCENT_RADIUS, nx2 = u.posx + SCENT_RADIUS;
+ const int ny1 = u.posy - SCENT_RADIUS, ny2 = u.posy + SCENT_RADIUS;
+ if (x2 < nx1 || x1 > nx2) {
+  scent_jobs.push_back(scent_rect(x1, 1, x2, last_y));
+  return;
+ }
+ if (x1 < nx1)
+  scent_jobs.push_back(scent_rect(x1, 1, nx1 - 1, last_y));
+ scent_jobs.push_back(scent_rect(std::max(x1, nx1), 1, std::min(x2, nx2),
+                                 ny1 - 1));
+ scent_jobs.push_back(scent_rect(std::max(x1, nx1), ny2 + 1,
+                                 std::min(x2, nx2), last_y));
+ if (x2 > nx2)
+  scent_jobs.push_back(scent_rect(nx2 + 1, 1, x2, last_y));
+}
+
+// Runs on the worker pool, so it only reads the map and oldscent, and only
+// writes its own rectangle of grscent
+void game::diffuse_scent_job(void *data, int index)
+{
+ game *g = (game *)data;
+ scent_rect &r = g->scent_jobs[index];
+ r.wacky = g->diffuse_scent(r.x1, r.y1, r.x2, r.y2);
+}
+
+// Spreads scent from oldscent into grscent over the rectangle from (x1, y1)
+// to (x2, y2), which must not touch the edge of the map; see
+// diffuse_scent_rows().  The terrain is gathered a submap at a time, rather
+// than through move_cost() and friends for every tile and each of its
+// neighbors.  Returns how many squares had wacky scent.
+int game::diffuse_scent(const int x1, const int y1, const int x2, const int y2)
+{
+ if (x1 > x2 || y1 > y2)
+  return 0;
+ scent_terrain *ter = new scent_terrain;
+ map_region reg = m.region(x1, y1, x2, y2);
+ for (int s = 0; s < reg.size(); s++) {
+  submap *sm = reg[s].sm;
+  for (int lx = reg[s].lx1; lx <= reg[s].lx2; lx++) {
+   for (int ly = reg[s].ly1; ly <= reg[s].ly2; ly++) {
+    const int x = reg[s].x + lx, y = reg[s].y + ly;
+    bool passable, bashable_ter;
+    if (m.veh_exists_at[x][y]) {
+     passable = (m.move_cost(x, y) != 0);
+     bashable_ter = m.has_flag(bashable, x, y);
+    } else {
+     passable = (terlist[sm->ter[lx][ly]].movecost != 0);
+     bashable_ter = (terlist[sm->ter[lx][ly]].flags & mfb(bashable));
+    }
+    ter->set(x, y, passable, bashable_ter,
+             sm->fld[lx][ly].type == fd_slime ? sm->fld[lx][ly].density : 0);
+   }
+  }
+ }
+ const int wacky = diffuse_scent_rows(oldscent, grscent, *ter, x1, y1, x2, y2);
+ delete ter;
+ return wacky;
+}
+
 bool game::is_game_over()
 {
  if (uquit != QUIT_NO)
@@ -1800,13 +1871,29 @@ void game::load(std::string name)
  if (OPTIONS[OPT_SAFEMODE] && run_mode == 0)
   run_mode = 1;
  autosafemode = OPTIONS[OPT_AUTOSAFEMODE];
- last_target = tmptar;
  weather = weather_type(tmpweather);
  temperature = tmptemp;
-// Next, the scent map.
- for (int i = 0; i < SEEX * MAPSIZE; i++) {
-  for (int j = 0; j < SEEY * MAPSIZE; j++)
-   fin >> grscent[i][j];
+// Next, the seed for rng_streams; saves from before there was one get a new
+// one.  Then the scent map.  It's run-length encoded, unless the save predates
+// that, in which case it's every square in turn.
+ short *scents = &(grscent[0][0]);
+ const int num_scents = SEEX * MAPSIZE * SEEY * MAPSIZE;
+ std::string scent_format;
+ fin >> scent_format;
+ if (scent_format == "seed")
+  fin >> rng_stream::game_seed >> scent_format;
+ else
+  rng_stream::game_seed = rand();
+ if (scent_format == "rle") {
+  int run, value;
+  for (int n = 0; n < num_scents && fin >> run >> value; ) {
+   for (; run > 0 && n < num_scents; run--)
+    scents[n++] = value;
+  }
+ } else {
+  scents[0] = atoi(scent_format.c_str());
+  for (int n = 1; n < num_scents; n++)
+   fin >> scents[n];
  }
 // Now the number of monsters...
  int nummon;
@@ -1814,6 +1901,8 @@ void game::load(std::string name)
 // ... and the data on each one.
  std::string data;
  z.clear();
+ monmap_changed();
+ sounds.clear(); // Anything still queued was made somewhere else
  monster montmp;
  char junk;
  if (fin.peek() == '\n')
@@ -1823,6 +1912,8 @@ void game::load(std::string name)
   montmp.load_info(data, &mtypes);
   z.push_back(montmp);
  }
+ last_target = (tmptar >= 0 && tmptar < z.size() ? z.handle(tmptar) :
+                mon_handle());
 // And the kill counts;
  if (fin.peek() == '\n')
   fin.get(junk); // Chomp that pesky endline
@@ -1874,16 +1965,24 @@ void game::save()
  masterfile << "save/master.gsav";
  fout.open(playerfile.str().c_str());
 // First, write out basic game state information.
- fout << int(turn) << " " << int(last_target) << " " << int(run_mode) << " " <<
+ fout << int(turn) << " " << z.index(last_target) << " " << int(run_mode) << " " <<
          mostseen << " " << nextinv << " " << next_npc_id << " " <<
          next_faction_id << " " << next_mission_id << " " << int(nextspawn) <<
          " " << int(nextweather) << " " << weather << " " << int(temperature) <<
          " " << levx << " " << levy << " " << levz << " " << cur_om.posx <<
          " " << cur_om.posy << " " << std::endl;
-// Next, the scent map.
- for (int i = 0; i < SEEX * MAPSIZE; i++) {
-  for (int j = 0; j < SEEY * MAPSIZE; j++)
-   fout << grscent[i][j] << " ";
+// Next, the seed for rng_streams, then the scent map, as runs of equal
+// values; most of it is 0.
+ fout << "seed " << rng_stream::game_seed << " ";
+ const short *scents = &(grscent[0][0]);
+ const int num_scents = SEEX * MAPSIZE * SEEY * MAPSIZE;
+ fout << "rle ";
+ for (int n = 0; n < num_scents; ) {
+  int run = 1;
+  while (n + run < num_scents && scents[n + run] == scents[n])
+   run++;
+  fout << run << " " << scents[n] << " ";
+  n += run;
  }
 // Now save all monsters.
  fout << std::endl << z.size() << std::endl;
@@ -2020,7 +2119,9 @@ void game::debug()
                    "Learn all melee styles", // 12
                    "Check NPC",              // 13
                    "Spawn Artifact",         // 14
-                   "Cancel",                 // 15
+                   "Benchmark line of sight",// 15
+                   "Benchmark lighting",     // 16
+                   "Cancel",                 // 17
                    NULL);
  int veh_num;
  std::vector<std::string> opts;
@@ -2037,6 +2138,7 @@ void game::debug()
    point tmp = cur_om.choose_point(this);
    if (tmp.x != -1) {
     z.clear();
+    monmap_changed();
     levx = tmp.x * 2 - int(MAPSIZE / 2);
     levy = tmp.y * 2 - int(MAPSIZE / 2);
     set_adjacent_overmaps(true);
@@ -2088,6 +2190,26 @@ z.size(), events.size());
    if (!active_npc.empty())
     popup_top("%s: %d:%d (you: %d:%d)", active_npc[0].name.c_str(),
               active_npc[0].posx, active_npc[0].posy, u.posx, u.posy);
+   popup_top("\
+NPC paths: %d reused, %d spliced, %d repaired, %d recomputed.",
+             npc::path_stats.hits, npc::path_stats.extended,
+             npc::path_stats.repaired, npc::path_stats.recomputed);
+   popup_top("\
+Monster LOS: %d ray walks saved.\n\
+%d checks answered from %d fields of view; %d lines picked.",
+             m.target_los_stats.queries - m.target_los_stats.walks,
+             m.target_los_stats.queries, m.target_los_stats.fovs,
+             m.target_los_stats.walks);
+   popup_top("\
+Light map: %d full, %d partial, %d unchanged redraws.",
+             lm.stats.full, lm.stats.partial, lm.stats.skipped);
+   popup_top("\
+Sound: %d sounds spread over %d turns, reaching %d squares.",
+             sounds.stats.events, sounds.stats.turns, sounds.stats.squares);
+   popup_top("\
+Monster AI last turn: %d full, %d coarse, %d idle.",
+             mon_lod_count[MLOD_FULL], mon_lod_count[MLOD_COARSE],
+             mon_lod_count[MLOD_IDLE]);
    break;
 
   case 8:
@@ -2158,6 +2280,27 @@ z.size(), events.size());
    }
   } break;
 
+  case 15: {
+   int table_ms, walk_ms, mismatches;
+   m.los_benchmark(100000, table_ms, walk_ms, mismatches);
+   popup_top("\
+100000 random sees() checks:\n\
+Ray tables: %d ms\n\
+Ray walking: %d ms\n\
+%d results differ.", table_ms, walk_ms, mismatches);
+  } break;
+
+  case 16: {
+   int shadow_ms, ray_ms, differ;
+   lm.benchmark(this, u.posx, u.posy, 50, shadow_ms, ray_ms, differ);
+   popup_top("\
+50 passes over 60 fires and 20 vehicles' headlights:\n\
+Shadowcasting: %d ms\n\
+Ray casting: %d ms\n\
+%d of %d squares lit differently.", shadow_ms, ray_ms, differ,
+             LIGHTMAP_X * LIGHTMAP_Y);
+  } break;
+
   case 14:
    point center = look_around();
    artifact_natural_property prop =
@@ -2542,6 +2685,7 @@ void game::draw_ter(int posx, int posy)
  if (posy == -999)
   posy = u.posy;
  int t = 0;
+ m.build_seen_cache(u.posx, u.posy);
  lm.generate(this, posx, posy, natural_light_level(), u.active_light());
  m.draw(this, w_terrain, point(posx, posy));
 
@@ -2926,6 +3070,23 @@ bool game::sees_u(int x, int y, int &t)
          m.sees(x, y, u.posx, u.posy, range, t));
 }
 
+bool game::sees_u(int x, int y)
+{
+ m.prepare_target_fov(u.posx, u.posy);
+ return sees_u(x, y, m.target_los_stats);
+}
+
+bool game::sees_u(int x, int y, los_stats &stats)
+{
+ int range = light_level();
+ if (lm.at(0, 0) >= LL_LOW)
+  range = rl_dist(x, y, u.posx, u.posy);
+
+ return (!u.has_active_bionic(bio_cloak) &&
+         !u.has_artifact_with(AEP_INVISIBLE) &&
+         m.target_sees(x, y, u.posx, u.posy, range, stats));
+}
+
 bool game::u_see(int x, int y, int &t)
 {
  int wanted_range = rl_dist(u.posx, u.posy, x, y);
@@ -2935,8 +3096,10 @@ bool game::u_see(int x, int y, int &t)
   can_see = true;
  else if (wanted_range <= u.sight_range(light_level()) ||
           (wanted_range <= u.sight_range(DAYLIGHT_LEVEL) &&
-            lm.at(x - u.posx, y - u.posy) >= LL_LOW))
-  can_see = m.sees(u.posx, u.posy, x, y, wanted_range, t);
+            lm.at(x - u.posx, y - u.posy) >= LL_LOW)) {
+  can_see = m.pl_sees(u.posx, u.posy, x, y, wanted_range);
+  t = 0; // The seen cache has no line; callers that need one use m.sees()
+ }
 
  return can_see;
 }
@@ -3233,16 +3396,8 @@ void game::mon_info()
 
 void game::cleanup_dead()
 {
- for (int i = 0; i < z.size(); i++) {
-  if (z[i].dead || z[i].hp <= 0) {
-   z.erase(z.begin() + i);
-   i--;
-  }
-  if (last_target == i)
-   last_target = -1;
-  else if (last_target > i)
-    last_target--;
- }
+ if (z.remove_dead() > 0)
+  monmap_changed();
 
  for (int i = 0; i < active_npc.size(); i++) {
   if (active_npc[i].dead) {
@@ -3252,9 +3407,162 @@ void game::cleanup_dead()
  }
 }
 
+// Alerts each monster that can hear to the loudest sound at its square, and
+// forgets the sounds.  Called before monsters plan, and again after each
+// monster or NPC moves, so that a sound is heard before anyone acts on the
+// map it was made in, as when game::sound() told every monster at once.
+void game::hear_sounds()
+{
+ if (sounds.empty())
+  return;
+ bool good_hearing = false;
+ for (int i = 0; i < z.size() && !good_hearing; i++)
+  good_hearing = z[i].has_flag(MF_GOODHEARING) && z[i].can_hear();
+ sounds.propagate(m, good_hearing);
+ for (int i = 0; i < z.size(); i++) {
+  const bool good = z[i].has_flag(MF_GOODHEARING);
+  int volume = sounds.volume_at(z[i].posx, z[i].posy, good);
+  if (volume <= 0 || !z[i].can_hear())
+   continue;
+  const sound_event &src = sounds.source_at(z[i].posx, z[i].posy, good);
+  z[i].wander_to(src.x, src.y, volume);
+  z[i].process_trigger(MTRIG_SOUND, volume);
+ }
+ sounds.clear();
+}
+
+// Monsters planning at once share out this many to a job
+#define PLAN_JOB_SIZE 16
+
+// Each monster that can act this turn plans its first move from where
+// everything stands at the start of the turn.  Then, one at a time in the
+// order of z, each claims the square it means to step into, or sidesteps one
+// already claimed.  The moves are made one at a time in monmove(), in the
+// same order, which settles anything the claims didn't.
+//
+// Hostile monsters plan on the worker pool.  Everything plan() would
+// otherwise work out lazily is built first: the light level, the monster
+// grid, the line table and the targets' fields of view.  Each monster rolls
+// from an rng_stream of its own, seeded by the turn and its handle.  Which
+// thread plans which monster then makes no difference.
+//
+// Monsters far from the player get less of it; see mon_lod().
+void game::plan_monsters()
+{
+ for (int n = 0; n < NUM_MLOD; n++)
+  mon_lod_count[n] = 0;
+ plan_order.clear();
+ bool any_see = false;
+ for (int i = 0; i < z.size(); i++) {
+  z[i].planned = false;
+  if (z[i].dead)
+   continue;
+  z[i].lod = mon_lod(z[i]);
+  mon_lod_count[z[i].lod]++;
+// Moves banked while thinking less often mustn't arrive all at once up close
+  if (z[i].lod == MLOD_FULL && z[i].moves > z[i].speed)
+   z[i].moves = z[i].speed;
+  if (z[i].moves <= 0 || !mon_thinks(i))
+   continue;
+  plan_order.push_back(i);
+  any_see |= z[i].can_see();
+ }
+ if (plan_order.empty())
+  return;
+
+ light_level();
+ sync_monmap();
+ map::build_ray_table();
+ if (any_see) {
+  m.prepare_target_fov(u.posx, u.posy);
+  for (int i = 0; i < active_npc.size(); i++)
+   m.prepare_target_fov(active_npc[i].posx, active_npc[i].posy);
+  for (int i = 0; i < z.size(); i++) {
+   if (z[i].friendly != 0 && !z[i].dead)
+    m.prepare_target_fov(z[i].posx, z[i].posy);
+  }
+ }
+
+// Pets first, since a pet growing restless changes what others see in it
+ if (plan_scratches.empty())
+  plan_scratches.resize(1);
+ std::vector<int> planning;
+ planning.swap(plan_order);
+ for (int n = 0; n < planning.size(); n++) {
+  const int i = planning[n];
+  if (z[i].friendly == 0) {
+   plan_order.push_back(i);
+   continue;
+  }
+  const mon_handle h = z.handle(i);
+  rng_stream dice(int(turn), h.slot, h.gen, 0);
+  z[i].plan(this, dice, plan_scratches[0]);
+ }
+ const int jobs = (plan_order.size() + PLAN_JOB_SIZE - 1) / PLAN_JOB_SIZE;
+ if (plan_scratches.size() < jobs)
+  plan_scratches.resize(jobs);
+ run_jobs(plan_job, this, jobs);
+ for (int j = 0; j < plan_scratches.size(); j++) {
+  m.target_los_stats.add(plan_scratches[j].los);
+  plan_scratches[j].los = los_stats();
+ }
+
+// Now the claims, in the order of z
+ for (int n = 0; n < planning.size(); n++) {
+  const int i = planning[n];
+  const mon_handle h = z.handle(i);
+  rng_stream dice(int(turn), h.slot, h.gen, 1);
+  z[i].claim_step(this, dice);
+  z[i].planned = true;
+ }
+}
+
+void game::plan_job(void *data, int index)
+{
+ game *g = (game *)data;
+ const int end = std::min(int(g->plan_order.size()),
+                          (index + 1) * PLAN_JOB_SIZE);
+ for (int n = index * PLAN_JOB_SIZE; n < end; n++) {
+  const int i = g->plan_order[n];
+  const mon_handle h = g->z.handle(i);
+  rng_stream dice(int(g->turn), h.slot, h.gen, 0);
+  g->z[i].plan(g, dice, g->plan_scratches[index]);
+ }
+}
+
+monster_lod game::mon_lod(monster &mon)
+{
+ if (OPTIONS[OPT_MONSTER_AI_INTERVAL] <= 1 || mon.friendly != 0 ||
+     rl_dist(mon.posx, mon.posy, u.posx, u.posy) <= MON_AI_RADIUS ||
+     (mon.can_see() && sees_u(mon.posx, mon.posy)))
+  return MLOD_FULL;
+ if (mon.wandf > 0 || !mon.wander() ||
+     (mon.has_flag(MF_SMELLS) && scent(mon.posx, mon.posy) > 0))
+  return MLOD_COARSE;
+ return MLOD_IDLE;
+}
+
+// Coarse monsters take turns thinking, a few at a time, and spend the moves
+// they saved up in between when they do.
+bool game::mon_thinks(int index)
+{
+ const int interval = int(OPTIONS[OPT_MONSTER_AI_INTERVAL]);
+ switch (z[index].lod) {
+  case MLOD_FULL:   return true;
+// Keyed on the handle's slot, which stays put when z swaps others out
+  case MLOD_COARSE:
+   return (interval <= 1 ||
+           (int(turn) + z.handle(index).slot) % interval == 0);
+  default:          return false;
+ }
+}
+
 void game::monmove()
 {
  cleanup_dead();
+ hear_sounds();
+ plan_monsters();
+ const int num_planned = z.size();
  for (int i = 0; i < z.size(); i++) {
   if (i < 0 || i > z.size())
   {
@@ -3280,8 +3588,7 @@ void game::monmove()
    for (int x = startx; x != endx && !okay; x += xdir) {
     for (int y = starty; y != endy && !okay; y += ydir){
      if (z[i].can_move_to(m, x, y)) {
-      z[i].posx = x;
-      z[i].posy = y;
+      z[i].setpos(this, x, y);
       okay = true;
      }
     }
@@ -3298,10 +3605,21 @@ void game::monmove()
 
   m.mon_in_field(z[i].posx, z[i].posy, this, &(z[i]));
 
-  while (z[i].moves > 0 && !z[i].dead) {
+  const bool thinks = (i >= num_planned || mon_thinks(i));
+  if (!thinks && z[i].lod == MLOD_IDLE && z[i].moves > 0)
+   z[i].moves = 0; // Nothing to save moves up for
+
+  int step = 0;
+  while (thinks && z[i].moves > 0 && !z[i].dead) {
    z[i].made_footstep = false;
-   z[i].plan(this);	// Formulate a path to follow
+   if (i >= num_planned || !z[i].planned) {	// Formulate a path to follow
+    const mon_handle h = z.handle(i);
+    rng_stream dice(int(turn), h.slot, h.gen, ++step + 1);
+    z[i].plan(this, dice, replan_scratch);
+   }
+   z[i].planned = false; // Only the first move of the turn was planned ahead
    z[i].move(this);	// Move one square, possibly hit u
+   hear_sounds();
    z[i].process_triggers(this);
    m.mon_in_field(z[i].posx, z[i].posy, this, &(z[i]));
    if (z[i].hurt(0)) {	// Maybe we died...
@@ -3342,6 +3660,8 @@ void game::monmove()
     z[i].receive_moves();
   }
  }
+ m.target_los_stats.add(replan_scratch.los);
+ replan_scratch.los = los_stats();
 
  cleanup_dead();
 
@@ -3356,7 +3676,7 @@ void game::monmove()
    while (!active_npc[i].dead && active_npc[i].moves > 0 && turns < 10) {
     turns++;
     active_npc[i].move(this);
-    //build_monmap();
+    hear_sounds();
    }
    if (turns == 10) {
     add_msg("%s's brain explodes!", active_npc[i].name.c_str());
@@ -3370,15 +3690,8 @@ void game::monmove()
 void game::sound(int x, int y, int vol, std::string description)
 {
  vol *= 1.5; // Scale it a little
-// First, alert all monsters (that can hear) to the sound
- for (int i = 0; i < z.size(); i++) {
-  if (z[i].can_hear()) {
-   int dist = rl_dist(x, y, z[i].posx, z[i].posy);
-   int volume = vol - (z[i].has_flag(MF_GOODHEARING) ? int(dist / 2) : dist);
-   z[i].wander_to(x, y, volume);
-   z[i].process_trigger(MTRIG_SOUND, volume);
-  }
- }
+// Monsters hear it at the next hear_sounds(), before any of them moves
+ sounds.add(x, y, vol);
 // Loud sounds make the next spawn sooner!
  int spawn_range = int(MAPSIZE / 2) * SEEX;
  if (vol >= spawn_range) {
@@ -3500,59 +3813,66 @@ void game::explosion(int x, int y, int power, int shrapnel, bool fire)
   sound(x, y, noise, "a huge explosion!");
  else
   sound(x, y, noise, "an explosion!");
- for (int i = x - radius; i <= x + radius; i++) {
-  for (int j = y - radius; j <= y + radius; j++) {
-   if (i == x && j == y)
-    dam = 3 * power;
-   else
-    dam = 3 * power / (rl_dist(x, y, i, j));
-   if (m.has_flag(bashable, i, j))
-    m.bash(i, j, dam, junk);
-   if (m.has_flag(bashable, i, j))	// Double up for tough doors, etc.
-    m.bash(i, j, dam, junk);
-   if (m.is_destructable(i, j) && rng(25, 100) < dam)
-    m.destroy(this, i, j, false);
-
-   int mon_hit = mon_at(i, j), npc_hit = npc_at(i, j);
-   if (mon_hit != -1 && !z[mon_hit].dead &&
-       z[mon_hit].hurt(rng(dam / 2, dam * 1.5))) {
-    if (z[mon_hit].hp < 0 - 1.5 * z[mon_hit].type->hp)
-     explode_mon(mon_hit); // Explode them if it was big overkill
+ map_region reg = m.region(point(x, y), radius);
+ for (int s = 0; s < reg.size(); s++) {
+  for (int li = reg[s].lx1; li <= reg[s].lx2; li++) {
+   for (int lj = reg[s].ly1; lj <= reg[s].ly2; lj++) {
+    const int i = reg[s].x + li, j = reg[s].y + lj;
+    if (i == x && j == y)
+     dam = 3 * power;
     else
-     kill_mon(mon_hit); // TODO: player's fault?
+     dam = 3 * power / (rl_dist(x, y, i, j));
+    if (m.has_flag(bashable, i, j))
+     m.bash(i, j, dam, junk);
+    if (m.has_flag(bashable, i, j))	// Double up for tough doors, etc.
+     m.bash(i, j, dam, junk);
+    if (m.is_destructable(i, j) && rng(25, 100) < dam)
+     m.destroy(this, i, j, false);
+
+    int mon_hit = mon_at(i, j), npc_hit = npc_at(i, j);
+    if (mon_hit != -1 && !z[mon_hit].dead &&
+        z[mon_hit].hurt(rng(dam / 2, dam * 1.5))) {
+     if (z[mon_hit].hp < 0 - 1.5 * z[mon_hit].type->hp)
+      explode_mon(mon_hit); // Explode them if it was big overkill
+     else
+      kill_mon(mon_hit); // TODO: player's fault?
 
-    int vpart;
-    vehicle *veh = m.veh_at(i, j, vpart);
-    if (veh)
-     veh->damage (vpart, dam, false);
-   }
+     int vpart;
+     vehicle *veh = m.veh_at(i, j, vpart);
+     if (veh)
+      veh->damage (vpart, dam, false);
+    }
 
-   if (npc_hit != -1) {
-    active_npc[npc_hit].hit(this, bp_torso, 0, rng(dam / 2, dam * 1.5), 0);
-    active_npc[npc_hit].hit(this, bp_head,  0, rng(dam / 3, dam),       0);
-    active_npc[npc_hit].hit(this, bp_legs,  0, rng(dam / 3, dam),       0);
-    active_npc[npc_hit].hit(this, bp_legs,  1, rng(dam / 3, dam),       0);
-    active_npc[npc_hit].hit(this, bp_arms,  0, rng(dam / 3, dam),       0);
-    active_npc[npc_hit].hit(this, bp_arms,  1, rng(dam / 3, dam),       0);
-    if (active_npc[npc_hit].hp_cur[hp_head]  <= 0 ||
-        active_npc[npc_hit].hp_cur[hp_torso] <= 0   ) {
-     active_npc[npc_hit].die(this, true);
-     //active_npc.erase(active_npc.begin() + npc_hit);
+    if (npc_hit != -1) {
+     active_npc[npc_hit].hit(this, bp_torso, 0, rng(dam / 2, dam * 1.5), 0);
+     active_npc[npc_hit].hit(this, bp_head,  0, rng(dam / 3, dam),       0);
+     active_npc[npc_hit].hit(this, bp_legs,  0, rng(dam / 3, dam),       0);
+     active_npc[npc_hit].hit(this, bp_legs,  1, rng(dam / 3, dam),       0);
+     active_npc[npc_hit].hit(this, bp_arms,  0, rng(dam / 3, dam),       0);
+     active_npc[npc_hit].hit(this, bp_arms,  1, rng(dam / 3, dam),       0);
+     if (active_npc[npc_hit].hp_cur[hp_head]  <= 0 ||
+         active_npc[npc_hit].hp_cur[hp_torso] <= 0   ) {
+      active_npc[npc_hit].die(this, true);
+      //active_npc.erase(active_npc.begin() + npc_hit);
+     }
+    }
+    if (u.posx == i && u.posy == j) {
+     add_msg("You're caught in the explosion!");
+     u.hit(this, bp_torso, 0, rng(dam / 2, dam * 1.5), 0);
+     u.hit(this, bp_head,  0, rng(dam / 3, dam),       0);
+     u.hit(this, bp_legs,  0, rng(dam / 3, dam),       0);
+     u.hit(this, bp_legs,  1, rng(dam / 3, dam),       0);
+     u.hit(this, bp_arms,  0, rng(dam / 3, dam),       0);
+     u.hit(this, bp_arms,  1, rng(dam / 3, dam),       0);
+    }
+    if (fire) {
+     field &fld = reg[s].sm->fld[li][lj];
+     if (fld.type == fd_smoke) {
+      fld = field(fd_fire, 1, 0);
+      m.add_light_emitter(i, j);
+     }
+     m.add_field(this, i, j, fd_fire, dam / 10);
     }
-   }
-   if (u.posx == i && u.posy == j) {
-    add_msg("You're caught in the explosion!");
-    u.hit(this, bp_torso, 0, rng(dam / 2, dam * 1.5), 0);
-    u.hit(this, bp_head,  0, rng(dam / 3, dam),       0);
-    u.hit(this, bp_legs,  0, rng(dam / 3, dam),       0);
-    u.hit(this, bp_legs,  1, rng(dam / 3, dam),       0);
-    u.hit(this, bp_arms,  0, rng(dam / 3, dam),       0);
-    u.hit(this, bp_arms,  1, rng(dam / 3, dam),       0);
-   }
-   if (fire) {
-    if (m.field_at(i, j).type == fd_smoke)
-     m.field_at(i, j) = field(fd_fire, 1, 0);
-    m.add_field(this, i, j, fd_fire, dam / 10);
    }
   }
  }
@@ -3704,8 +4024,10 @@ void game::resonance_cascade(int x, int y)
        case 6:
        case 7: type = fd_nuke_gas;
       }
-      if (m.field_at(k, l).type == fd_null || !one_in(3))
-       m.field_at(k, l) = field(type, 3, 0);
+      if (m.field_at(k, l).type == fd_null || !one_in(3)) {
+       m.remove_field(k, l);
+       m.add_field(NULL, k, l, type, 3);
+      }
      }
     }
     break;
@@ -3754,7 +4076,7 @@ void game::emp_blast(int x, int y)
  int rn;
  if (m.has_flag(console, x, y)) {
   add_msg("The %s is rendered non-functional!", m.tername(x, y).c_str());
-  m.ter(x, y) = t_console_broken;
+  m.ter_set(x, y, t_console_broken);
   return;
  }
 // TODO: More terrain effects.
@@ -3764,14 +4086,14 @@ void game::emp_blast(int x, int y)
   rn = rng(1, 100);
   if (rn > 92 || rn < 40) {
    add_msg("The card reader is rendered non-functional.");
-   m.ter(x, y) = t_card_reader_broken;
+   m.ter_set(x, y, t_card_reader_broken);
   }
   if (rn > 80) {
    add_msg("The nearby doors slide open!");
    for (int i = -3; i <= 3; i++) {
     for (int j = -3; j <= 3; j++) {
      if (m.ter(x + i, y + j) == t_door_metal_locked)
-      m.ter(x + i, y + j) = t_floor;
+      m.ter_set(x + i, y + j, t_floor);
     }
    }
   }
@@ -3828,22 +4150,204 @@ int game::npc_by_id(int id)
 
 int game::mon_at(int x, int y)
 {
- for (int i = 0; i < z.size(); i++) {
-  if (z[i].posx == x && z[i].posy == y) {
-   if (z[i].dead)
-    return -1;
-   else
-    return i;
+ if (x < 0 || x >= SEEX * MAPSIZE || y < 0 || y >= SEEY * MAPSIZE) {
+  for (int i = 0; i < z.size(); i++) { // Off the map; only when shifting
+   if (z[i].posx == x && z[i].posy == y)
+    return (z[i].dead ? -1 : i);
   }
+  return -1;
+ }
+ sync_monmap();
+ int index = monmap[x][y];
+ if (index != -1 && z[index].dead)
+  index = -1;
+ if (debugmon) { // Check the grid against a search of z
+  int found = -1;
+  for (int i = 0; i < z.size() && found == -1; i++) {
+   if (!z[i].dead && z[i].posx == x && z[i].posy == y)
+    found = i;
+  }
+  if (found != index)
+   debugmsg("mon_at(%d, %d) found monster %d, but the grid has %d", x, y,
+            found, index);
+ }
+ return index;
+}
+
+// Brings monmap up to date with z: all of it if monsters have been removed,
+// otherwise just those added since.  Where two monsters share a square the
+// first live one in z is the one found, as a search of z would.
+void game::sync_monmap()
+{
+ if (monmap_size == z.size())
+  return;
+ if (monmap_size < 0 || monmap_size > z.size()) {
+  for (int x = 0; x < SEEX * MAPSIZE; x++) {
+   for (int y = 0; y < SEEY * MAPSIZE; y++)
+    monmap[x][y] = -1;
+  }
+  for (int x = 0; x < MAPSIZE; x++) {
+   for (int y = 0; y < MAPSIZE; y++)
+    monmap_count[x][y] = 0;
+  }
+  monmap_size = 0;
+ }
+ for (int i = monmap_size; i < z.size(); i++) {
+  const int x = z[i].posx, y = z[i].posy;
+  if (x < 0 || x >= SEEX * MAPSIZE || y < 0 || y >= SEEY * MAPSIZE)
+   continue;
+  if (monmap[x][y] == -1) {
+   monmap[x][y] = i;
+   monmap_count[x / SEEX][y / SEEY]++;
+  } else if (z[monmap[x][y]].dead)
+   monmap[x][y] = i;
+ }
+ monmap_size = z.size();
+}
+
+void game::mon_moved(const monster *mon, int oldx, int oldy)
+{
+ if (z.empty() || mon < &z[0] || mon >= &z[0] + monmap_size)
+  return; // Not in z, or not in monmap yet
+ const int index = mon - &z[0];
+ if (oldx >= 0 && oldx < SEEX * MAPSIZE && oldy >= 0 && oldy < SEEY * MAPSIZE &&
+     monmap[oldx][oldy] == index) {
+  monmap[oldx][oldy] = -1;
+  monmap_count[oldx / SEEX][oldy / SEEY]--;
+ }
+ const int x = mon->posx, y = mon->posy;
+ if (x >= 0 && x < SEEX * MAPSIZE && y >= 0 && y < SEEY * MAPSIZE) {
+  if (monmap[x][y] == -1)
+   monmap_count[x / SEEX][y / SEEY]++;
+  monmap[x][y] = index;
+ }
+}
+
+// The monsters in the rectangle, in the order of z.  Only the squares of
+// submaps with a monster in them are looked at.
+std::vector<int> game::mons_in_rect(int x1, int y1, int x2, int y2)
+{
+ std::vector<int> ret;
+ mons_in_rect(x1, y1, x2, y2, ret);
+ return ret;
+}
+
+void game::mons_in_rect(int x1, int y1, int x2, int y2, std::vector<int> &ret)
+{
+ ret.clear();
+ x1 = std::max(x1, 0);
+ y1 = std::max(y1, 0);
+ x2 = std::min(x2, SEEX * MAPSIZE - 1);
+ y2 = std::min(y2, SEEY * MAPSIZE - 1);
+ if (x1 > x2 || y1 > y2)
+  return;
+ sync_monmap();
+ for (int sx = x1 / SEEX; sx <= x2 / SEEX; sx++) {
+  for (int sy = y1 / SEEY; sy <= y2 / SEEY; sy++) {
+   if (monmap_count[sx][sy] == 0)
+    continue;
+   const int lx = std::max(x1, sx * SEEX), hx = std::min(x2, sx * SEEX + SEEX - 1);
+   const int ly = std::max(y1, sy * SEEY), hy = std::min(y2, sy * SEEY + SEEY - 1);
+   for (int x = lx; x <= hx; x++) {
+    for (int y = ly; y <= hy; y++) {
+     if (monmap[x][y] != -1 && !z[monmap[x][y]].dead)
+      ret.push_back(monmap[x][y]);
+    }
+   }
+  }
+ }
+ std::sort(ret.begin(), ret.end());
+}
+
+std::vector<int> game::mons_in_radius(int x, int y, int radius)
+{
+ // rl_dist() is square, so the rectangle is exactly the radius
+ return mons_in_rect(x - radius, y - radius, x + radius, y + radius);
+}
+
+struct mon_by_distance {
+ game *g;
+ int x, y;
+ bool operator()(int a, int b) const
+ {
+  const int da = rl_dist(x, y, g->z[a].posx, g->z[a].posy);
+  const int db = rl_dist(x, y, g->z[b].posx, g->z[b].posy);
+  return (da < db || (da == db && a < b));
+ }
+};
+
+std::vector<int> game::nearest_mons(int x, int y, int radius, int count)
+{
+ std::vector<int> ret;
+ nearest_mons(x, y, radius, ret, count);
+ return ret;
+}
+
+// Nearest first, ties in the order of z; so the first that passes a test is
+// the one a search of z for the closest would have found.
+void game::nearest_mons(int x, int y, int radius, std::vector<int> &ret,
+                        int count)
+{
+ mons_in_rect(x - radius, y - radius, x + radius, y + radius, ret);
+ mon_by_distance closer;
+ closer.g = this;
+ closer.x = x;
+ closer.y = y;
+ if (count > 0 && count < ret.size()) {
+  std::partial_sort(ret.begin(), ret.begin() + count, ret.end(), closer);
+  ret.resize(count);
+ } else
+  std::sort(ret.begin(), ret.end(), closer);
+}
+
+void game::monmap_changed()
+{
+ monmap_size = -1;
+}
+
+creature_ref game::creature_at(int x, int y)
+{
+ if (u.posx == x && u.posy == y)
+  return creature_ref(CREATURE_PLAYER);
+ int index = npc_at(x, y); // There are few enough NPCs to just search them
+ if (index != -1)
+  return creature_ref(CREATURE_NPC, index);
+ index = mon_at(x, y);
+ if (index != -1)
+  return creature_ref(CREATURE_MONSTER, index);
+ return creature_ref();
+}
+
+bool game::claim(int x, int y)
+{
+ if (x < 0 || x >= SEEX * MAPSIZE || y < 0 || y >= SEEY * MAPSIZE)
+  return true; // Nobody else is going to be moving out there
+ if (claims[x][y] == int(turn))
+  return false;
+ claims[x][y] = int(turn);
+ return true;
+}
+
+bool game::claimed(int x, int y)
+{
+ if (x < 0 || x >= SEEX * MAPSIZE || y < 0 || y >= SEEY * MAPSIZE)
+  return false;
+ return (claims[x][y] == int(turn));
+}
+
+// Claims are made in map coordinates, so they're dropped when the map shifts
+void game::clear_claims()
+{
+ for (int x = 0; x < SEEX * MAPSIZE; x++) {
+  for (int y = 0; y < SEEY * MAPSIZE; y++)
+   claims[x][y] = -1;
  }
- return -1;
 }
 
 bool game::is_empty(int x, int y)
 {
  return ((m.move_cost(x, y) > 0 || m.has_flag(liquid, x, y)) &&
-         npc_at(x, y) == -1 && mon_at(x, y) == -1 &&
-         (u.posx != x || u.posy != y));
+         creature_at(x, y).empty());
 }
 
 bool game::is_in_sunlight(int x, int y)
@@ -3870,8 +4374,9 @@ void game::kill_mon(int index, bool u_did_it)
    if (z[index].type->species != species_hallu)
     kills[z[index].type->id]++;	// Increment our kill counter
   }
-  for (int i = 0; i < z[index].inv.size(); i++)
-   m.add_item(z[index].posx, z[index].posy, z[index].inv[i]);
+  const std::vector<item> &inv = z[index].inv();
+  for (int i = 0; i < inv.size(); i++)
+   m.add_item(z[index].posx, z[index].posy, inv[i]);
   z[index].die(this);
  }
 }
@@ -3950,11 +4455,8 @@ void game::explode_mon(int index)
   }
  }
 
- z.erase(z.begin()+index);
- if (last_target == index)
-  last_target = -1;
- else if (last_target > index)
-   last_target--;
+ z.remove(index);
+ monmap_changed();
 }
 
 void game::open()
@@ -4366,12 +4868,13 @@ void game::examine()
    for (int i = -3; i <= 3; i++) {
     for (int j = -3; j <= 3; j++) {
      if (m.ter(examx + i, examy + j) == t_door_metal_locked)
-      m.ter(examx + i, examy + j) = t_floor;
+      m.ter_set(examx + i, examy + j, t_floor);
     }
    }
    for (int i = 0; i < z.size(); i++) {
     if (z[i].type->id == mon_turret) {
-     z.erase(z.begin() + i);
+     z.remove(i);
+     monmap_changed();
      i--;
     }
    }
@@ -4406,17 +4909,17 @@ void game::examine()
       u.charge_power(0 - rng(0, u.power_level));
      }
     }
-    m.ter(examx, examy) = t_card_reader_broken;
+    m.ter_set(examx, examy, t_card_reader_broken);
    } else if (success < 6)
     add_msg("Nothing happens.");
    else {
     add_msg("You activate the panel!");
     add_msg("The nearby doors slide into the floor.");
-    m.ter(examx, examy) = t_card_reader_broken;
+    m.ter_set(examx, examy, t_card_reader_broken);
     for (int i = -3; i <= 3; i++) {
      for (int j = -3; j <= 3; j++) {
       if (m.ter(examx + i, examy + j) == t_door_metal_locked)
-       m.ter(examx + i, examy + j) = t_floor;
+       m.ter_set(examx + i, examy + j, t_floor);
      }
     }
    }
@@ -4458,7 +4961,7 @@ void game::examine()
         if (m.ter(examx-1, examy+y_offst) == t_floor) x_incr = -1;
         int cur_x = examx+x_incr;
         while (m.ter(cur_x, examy+y_offst)== t_floor) {
-            m.ter(cur_x, examy+y_offst) = t_door_metal_locked;
+            m.ter_set(cur_x, examy+y_offst, t_door_metal_locked);
             cur_x = cur_x+x_incr;                              }
     } else //vertical orientation of the gate
     if ((m.ter(examx-1, examy)==t_wall_v)||(m.ter(examx+1, examy)==t_wall_v)) {
@@ -4472,7 +4975,7 @@ void game::examine()
             add_msg(dzebugg);
         int cur_y = examy+y_incr;
         while (m.ter(examx+x_offst, cur_y)==t_floor) {
-            m.ter(examx+x_offst, cur_y) = t_door_metal_locked;
+            m.ter_set(examx+x_offst, cur_y, t_door_metal_locked);
             cur_y = cur_y+y_incr;
             }
         }
@@ -4491,7 +4994,7 @@ void game::examine()
         if (m.ter(examx-1, examy+y_offst) == t_floor) x_incr = -1;
         int cur_x = examx+x_incr;
         while (m.ter(cur_x, examy+y_offst)== t_floor) {
-            m.ter(cur_x, examy+y_offst) = t_door_metal_locked;
+            m.ter_set(cur_x, examy+y_offst, t_door_metal_locked);
             cur_x = cur_x+x_incr;                              }
     } else //vertical orientation of the gate
     if ((m.ter(examx-1, examy)==t_wall_v)||(m.ter(examx+1, examy)==t_wall_v)) {
@@ -4505,7 +5008,7 @@ void game::examine()
             add_msg(dzebugg);*/
         int cur_y = examy+y_incr;
         while (m.ter(examx+x_offst, cur_y)==t_floor) {
-            m.ter(examx+x_offst, cur_y) = t_door_metal_locked;
+            m.ter_set(examx+x_offst, cur_y, t_door_metal_locked);
             cur_y = cur_y+y_incr;
         }
     }
@@ -4523,7 +5026,7 @@ void game::examine()
         if (m.ter(examx-1, examy+y_offst) == t_door_metal_locked) x_incr = -1;
         int cur_x = examx+x_incr;
         while (m.ter(cur_x, examy+y_offst)==t_door_metal_locked) {
-            m.ter(cur_x, examy+y_offst) = t_floor;
+            m.ter_set(cur_x, examy+y_offst, t_floor);
             cur_x = cur_x+x_incr;                              }
     } else //vertical orientation of the gate
     if ((m.ter(examx-1, examy)==t_wall_v)||(m.ter(examx+1, examy)==t_wall_v)) {
@@ -4534,33 +5037,33 @@ void game::examine()
         if (m.ter(examx+x_offst, examy+1)== t_door_metal_locked) y_incr = 1;
         int cur_y = examy+y_incr;
         while (m.ter(examx+x_offst, cur_y)==t_door_metal_locked) {
-            m.ter(examx+x_offst, cur_y) = t_floor;
+            m.ter_set(examx+x_offst, cur_y, t_floor);
             cur_y = cur_y+y_incr;
         }
     }
     add_msg("The gate is opened!");
   }
 /* } else if (m.ter(examx, examy) == t_dirt || m.ter(examx, examy) == t_grass) {
-    m.ter(examx, examy) = t_wall_wood;
-    m.ter(examx, examy) = t_shrub;
-    m.ter(examx, examy) = t_underbrush;
-    m.ter(examx, examy) = t_wall_v;
-    m.ter(examx, examy) = t_wall_h;
-    m.ter(examx, examy) = t_water_dp;
+    m.ter_set(examx, examy, t_wall_wood);
+    m.ter_set(examx, examy, t_shrub);
+    m.ter_set(examx, examy, t_underbrush);
+    m.ter_set(examx, examy, t_wall_v);
+    m.ter_set(examx, examy, t_wall_h);
+    m.ter_set(examx, examy, t_water_dp);
 */
 //Debug for testing things
  } else if (m.ter(examx, examy) == t_rubble && u.has_amount(itm_shovel, 1)) {
   if (query_yn("Clear up that rubble?")) {
   if (levz == -1) {
    u.moves -= 200;
-   m.ter(examx, examy) = t_rock_floor;
+   m.ter_set(examx, examy, t_rock_floor);
    item rock(itypes[itm_rock], turn);
    m.add_item(u.posx, u.posy, rock);
    m.add_item(u.posx, u.posy, rock);
    add_msg("You clear the rubble up");
  } else {
    u.moves -= 200;
-   m.ter(examx, examy) = t_dirt;
+   m.ter_set(examx, examy, t_dirt);
    item rock(itypes[itm_rock], turn);
    m.add_item(u.posx, u.posy, rock);
    m.add_item(u.posx, u.posy, rock);
@@ -4572,11 +5075,11 @@ void game::examine()
   if (query_yn("Clear up that rubble?")) {
   if (levz == -1) {
    u.moves -= 200;
-   m.ter(examx, examy) = t_rock_floor;
+   m.ter_set(examx, examy, t_rock_floor);
    add_msg("You clear the ash up");
  } else {
    u.moves -= 200;
-   m.ter(examx, examy) = t_dirt;
+   m.ter_set(examx, examy, t_dirt);
    add_msg("You clear the ash up");
  }} else {
    add_msg("You need a shovel to do that!");
@@ -4593,22 +5096,22 @@ void game::examine()
   }
  } else if (m.ter(examx, examy) == t_groundsheet && query_yn("Take down tent?")) {
    u.moves -= 200;
-   m.ter(examx    , examy    ) = t_dirt;
-   m.ter(examx - 1, examy - 1) = t_dirt;
-   m.ter(examx - 1, examy    ) = t_dirt;
-   m.ter(examx - 1, examy + 1) = t_dirt;
-   m.ter(examx    , examy - 1) = t_dirt;
-   m.ter(examx    , examy + 1) = t_dirt;
-   m.ter(examx + 1, examy - 1) = t_dirt;
-   m.ter(examx + 1, examy    ) = t_dirt;
-   m.ter(examx + 1, examy + 1) = t_dirt;
+   m.ter_set(examx    , examy    , t_dirt);
+   m.ter_set(examx - 1, examy - 1, t_dirt);
+   m.ter_set(examx - 1, examy    , t_dirt);
+   m.ter_set(examx - 1, examy + 1, t_dirt);
+   m.ter_set(examx    , examy - 1, t_dirt);
+   m.ter_set(examx    , examy + 1, t_dirt);
+   m.ter_set(examx + 1, examy - 1, t_dirt);
+   m.ter_set(examx + 1, examy    , t_dirt);
+   m.ter_set(examx + 1, examy + 1, t_dirt);
   add_msg("You take down the tent");
   item tent(itypes[itm_tent_kit], turn);
   m.add_item(examx, examy, tent);
  } else if (m.ter(examx, examy) == t_wreckage && u.has_amount(itm_shovel, 1)) {
   if (query_yn("Clear up that wreckage?")) {
    u.moves -= 200;
-   m.ter(examx, examy) = t_dirt;
+   m.ter_set(examx, examy, t_dirt);
    item chunk(itypes[itm_steel_chunk], turn);
    item scrap(itypes[itm_scrap], turn);
    item pipe(itypes[itm_pipe], turn);
@@ -4625,7 +5128,7 @@ void game::examine()
  } else if (m.ter(examx, examy) == t_metal && u.has_amount(itm_shovel, 1)) {
   if (query_yn("Clear up that wreckage?")) {
    u.moves -= 200;
-   m.ter(examx, examy) = t_floor;
+   m.ter_set(examx, examy, t_floor);
    item chunk(itypes[itm_steel_chunk], turn);
    item scrap(itypes[itm_scrap], turn);
    item pipe(itypes[itm_pipe], turn);
@@ -4640,7 +5143,7 @@ void game::examine()
  } else if (m.ter(examx, examy) == t_pit && u.has_amount(itm_2x4, 1)) {
   if (query_yn("Place a plank over the pit?")) {
    u.use_amount(itm_2x4, 1);
-   m.ter(examx, examy) = t_pit_covered;
+   m.ter_set(examx, examy, t_pit_covered);
    add_msg("You place a plank of wood over the pit");
  } else {
    add_msg("You need a plank of wood to do that");
@@ -4648,7 +5151,7 @@ void game::examine()
  } else if (m.ter(examx, examy) == t_pit_spiked && u.has_amount(itm_2x4, 1)) {
   if (query_yn("Place a plank over the pit?")) {
    u.use_amount(itm_2x4, 1);
-   m.ter(examx, examy) = t_pit_spiked_covered;
+   m.ter_set(examx, examy, t_pit_spiked_covered);
    add_msg("You place a plank of wood over the pit");
  } else {
    add_msg("You need a plank of wood to do that");
@@ -4657,12 +5160,12 @@ void game::examine()
     item plank(itypes[itm_2x4], turn);
     add_msg("You remove the plank.");
      m.add_item(u.posx, u.posy, plank);
-     m.ter(examx, examy) = t_pit;
+     m.ter_set(examx, examy, t_pit);
  } else if (m.ter(examx, examy) == t_pit_spiked_covered && query_yn("Remove that plank?")) {
     item plank(itypes[itm_2x4], turn);
     add_msg("You remove the plank.");
      m.add_item(u.posx, u.posy, plank);
-     m.ter(examx, examy) = t_pit_spiked;
+     m.ter_set(examx, examy, t_pit_spiked);
  } else if (m.ter(examx, examy) == t_gas_pump && query_yn("Pump gas?")) {
   item gas(itypes[itm_gasoline], turn);
   if (one_in(10 + u.dex_cur)) {
@@ -4679,7 +5182,7 @@ void game::examine()
    case 1:{
   if (u.has_amount(itm_rope_6, 2)) {
    u.use_amount(itm_rope_6, 2);
-   m.ter(examx, examy) = t_fence_rope;
+   m.ter_set(examx, examy, t_fence_rope);
    u.moves -= 200;
   } else
    add_msg("You need 2 six-foot lengths of rope to do that");
@@ -4688,7 +5191,7 @@ void game::examine()
    case 2:{
   if (u.has_amount(itm_wire, 2)) {
    u.use_amount(itm_wire, 2);
-   m.ter(examx, examy) = t_fence_wire;
+   m.ter_set(examx, examy, t_fence_wire);
    u.moves -= 200;
   } else
    add_msg("You need 2 lengths of wire to do that!");
@@ -4697,7 +5200,7 @@ void game::examine()
    case 3:{
   if (u.has_amount(itm_wire_barbed, 2)) {
    u.use_amount(itm_wire_barbed, 2);
-   m.ter(examx, examy) = t_fence_barbed;
+   m.ter_set(examx, examy, t_fence_barbed);
    u.moves -= 200;
   } else
    add_msg("You need 2 lengths of barbed wire to do that!");
@@ -4710,20 +5213,20 @@ void game::examine()
   item rope(itypes[itm_rope_6], turn);
   m.add_item(u.posx, u.posy, rope);
   m.add_item(u.posx, u.posy, rope);
-  m.ter(examx, examy) = t_fence_post;
+  m.ter_set(examx, examy, t_fence_post);
   u.moves -= 200;
 
  } else if (m.ter(examx, examy) == t_fence_wire && query_yn("Remove fence material?")) {
   item rope(itypes[itm_wire], turn);
   m.add_item(u.posx, u.posy, rope);
   m.add_item(u.posx, u.posy, rope);
-  m.ter(examx, examy) = t_fence_post;
+  m.ter_set(examx, examy, t_fence_post);
   u.moves -= 200;
  } else if (m.ter(examx, examy) == t_fence_barbed && query_yn("Remove fence material?")) {
   item rope(itypes[itm_wire_barbed], turn);
   m.add_item(u.posx, u.posy, rope);
   m.add_item(u.posx, u.posy, rope);
-  m.ter(examx, examy) = t_fence_post;
+  m.ter_set(examx, examy, t_fence_post);
   u.moves -= 200;
 
  } else if (m.ter(examx, examy) == t_slot_machine) {
@@ -4769,20 +5272,20 @@ shape, but with long, twisted, distended limbs.");
  } else if (m.ter(examx, examy) == t_pedestal_wyrm &&
             m.i_at(examx, examy).empty()) {
   add_msg("The pedestal sinks into the ground...");
-  m.ter(examx, examy) = t_rock_floor;
+  m.ter_set(examx, examy, t_rock_floor);
   add_event(EVENT_SPAWN_WYRMS, int(turn) + rng(5, 10));
  } else if (m.ter(examx, examy) == t_pedestal_temple) {
   if (m.i_at(examx, examy).size() == 1 &&
       m.i_at(examx, examy)[0].type->id == itm_petrified_eye) {
    add_msg("The pedestal sinks into the ground...");
-   m.ter(examx, examy) = t_dirt;
+   m.ter_set(examx, examy, t_dirt);
    m.i_at(examx, examy).clear();
    add_event(EVENT_TEMPLE_OPEN, int(turn) + 4);
   } else if (u.has_amount(itm_petrified_eye, 1) &&
              query_yn("Place your petrified eye on the pedestal?")) {
    u.use_amount(itm_petrified_eye, 1);
    add_msg("The pedestal sinks into the ground...");
-   m.ter(examx, examy) = t_dirt;
+   m.ter_set(examx, examy, t_dirt);
    add_event(EVENT_TEMPLE_OPEN, int(turn) + 4);
   } else
    add_msg("This pedestal is engraved in eye-shaped diagrams, and has a large\
@@ -4796,48 +5299,48 @@ shape, but with long, twisted, distended limbs.");
     switch (m.ter(examx, examy)) {
      case t_switch_rg:
       if (m.ter(x, y) == t_rock_red)
-       m.ter(x, y) = t_floor_red;
+       m.ter_set(x, y, t_floor_red);
       else if (m.ter(x, y) == t_floor_red)
-       m.ter(x, y) = t_rock_red;
+       m.ter_set(x, y, t_rock_red);
       else if (m.ter(x, y) == t_rock_green)
-       m.ter(x, y) = t_floor_green;
+       m.ter_set(x, y, t_floor_green);
       else if (m.ter(x, y) == t_floor_green)
-       m.ter(x, y) = t_rock_green;
+       m.ter_set(x, y, t_rock_green);
       break;
      case t_switch_gb:
       if (m.ter(x, y) == t_rock_blue)
-       m.ter(x, y) = t_floor_blue;
+       m.ter_set(x, y, t_floor_blue);
       else if (m.ter(x, y) == t_floor_blue)
-       m.ter(x, y) = t_rock_blue;
+       m.ter_set(x, y, t_rock_blue);
       else if (m.ter(x, y) == t_rock_green)
-       m.ter(x, y) = t_floor_green;
+       m.ter_set(x, y, t_floor_green);
       else if (m.ter(x, y) == t_floor_green)
-       m.ter(x, y) = t_rock_green;
+       m.ter_set(x, y, t_rock_green);
       break;
      case t_switch_rb:
       if (m.ter(x, y) == t_rock_blue)
-       m.ter(x, y) = t_floor_blue;
+       m.ter_set(x, y, t_floor_blue);
       else if (m.ter(x, y) == t_floor_blue)
-       m.ter(x, y) = t_rock_blue;
+       m.ter_set(x, y, t_rock_blue);
       else if (m.ter(x, y) == t_rock_red)
-       m.ter(x, y) = t_floor_red;
+       m.ter_set(x, y, t_floor_red);
       else if (m.ter(x, y) == t_floor_red)
-       m.ter(x, y) = t_rock_red;
+       m.ter_set(x, y, t_rock_red);
       break;
      case t_switch_even:
       if ((y - examy) % 2 == 1) {
        if (m.ter(x, y) == t_rock_red)
-        m.ter(x, y) = t_floor_red;
+        m.ter_set(x, y, t_floor_red);
        else if (m.ter(x, y) == t_floor_red)
-        m.ter(x, y) = t_rock_red;
+        m.ter_set(x, y, t_rock_red);
        else if (m.ter(x, y) == t_rock_green)
-        m.ter(x, y) = t_floor_green;
+        m.ter_set(x, y, t_floor_green);
        else if (m.ter(x, y) == t_floor_green)
-        m.ter(x, y) = t_rock_green;
+        m.ter_set(x, y, t_rock_green);
        else if (m.ter(x, y) == t_rock_blue)
-        m.ter(x, y) = t_floor_blue;
+        m.ter_set(x, y, t_floor_blue);
        else if (m.ter(x, y) == t_floor_blue)
-        m.ter(x, y) = t_rock_blue;
+        m.ter_set(x, y, t_rock_blue);
       }
       break;
     }
@@ -4858,7 +5361,7 @@ shape, but with long, twisted, distended limbs.");
         u.hurt(this,bp_legs, 0, 4);
         u.moves-=50;
         }
-        m.ter(examx, examy) = t_dirt;
+        m.ter_set(examx, examy, t_dirt);
         m.add_item(examx, examy, this->itypes[itm_poppy_flower],0);
         m.add_item(examx, examy, this->itypes[itm_poppy_bud],0);
     }
@@ -5808,27 +6311,25 @@ void game::plthrow()
   }
  }
 
- std::vector <monster> mon_targets;
  std::vector <int> targetindices;
  int passtarget = -1;
  for (int i = 0; i < z.size(); i++) {
   if (u_see(&(z[i]), junk) && z[i].posx >= x0 && z[i].posx <= x1 &&
                               z[i].posy >= y0 && z[i].posy <= y1) {
-   mon_targets.push_back(z[i]);
    targetindices.push_back(i);
-   if (i == last_target)
-    passtarget = mon_targets.size() - 1;
+   if (z.handle(i) == last_target)
+    passtarget = targetindices.size() - 1;
    z[i].draw(w_terrain, u.posx, u.posy, true);
   }
  }
 
  // target() sets x and y, or returns false if we canceled (by pressing Esc)
- std::vector <point> trajectory = target(x, y, x0, y0, x1, y1, mon_targets,
+ std::vector <point> trajectory = target(x, y, x0, y0, x1, y1, targetindices,
                                          passtarget, &thrown);
  if (trajectory.size() == 0)
   return;
  if (passtarget != -1)
-  last_target = targetindices[passtarget];
+  last_target = z.handle(targetindices[passtarget]);
 
  u.i_rem(ch);
  u.moves -= 125;
@@ -5909,23 +6410,21 @@ void game::plfire(bool burst)
   }
  }
 // Populate a list of targets with the zombies in range and visible
- std::vector <monster> mon_targets;
  std::vector <int> targetindices;
  int passtarget = -1;
  for (int i = 0; i < z.size(); i++) {
   if (z[i].posx >= x0 && z[i].posx <= x1 &&
       z[i].posy >= y0 && z[i].posy <= y1 &&
       z[i].friendly == 0 && u_see(&(z[i]), junk)) {
-   mon_targets.push_back(z[i]);
    targetindices.push_back(i);
-   if (i == last_target)
-    passtarget = mon_targets.size() - 1;
+   if (z.handle(i) == last_target)
+    passtarget = targetindices.size() - 1;
    z[i].draw(w_terrain, u.posx, u.posy, true);
   }
  }
 
  // target() sets x and y, and returns an empty vector if we canceled (Esc)
- std::vector <point> trajectory = target(x, y, x0, y0, x1, y1, mon_targets,
+ std::vector <point> trajectory = target(x, y, x0, y0, x1, y1, targetindices,
                                          passtarget, &u.weapon);
  draw_ter(); // Recenter our view
  if (trajectory.size() == 0) {
@@ -5934,7 +6433,7 @@ void game::plfire(bool burst)
   return;
  }
  if (passtarget != -1) { // We picked a real live target
-  last_target = targetindices[passtarget]; // Make it our default for next time
+  last_target = z.handle(targetindices[passtarget]); // Make it our default for next time
   z[targetindices[passtarget]].add_effect(ME_HIT_BY_PLAYER, 100);
  }
 
@@ -6092,7 +6591,7 @@ void game::eat()
      query_yn("Eat underbrush?")) {
   u.moves -= 400;
   u.hunger -= 10;
-  m.ter(u.posx, u.posy) = t_grass;
+  m.ter_set(u.posx, u.posy, t_grass);
   add_msg("You eat the underbrush.");
   return;
  }
@@ -6607,9 +7106,10 @@ void game::plmove(int x, int y)
 // TODO: Make there a flag, instead of hard-coded to mon_turret
     if (z[mondex].type->id == mon_turret) {
      if (query_yn("Deactivate the turret?")) {
-      z.erase(z.begin() + mondex);
-      u.moves -= 100;
       m.add_item(z[mondex].posx, z[mondex].posy, itypes[itm_bot_turret], turn);
+      z.remove(mondex);
+      monmap_changed();
+      u.moves -= 100;
      }
      return;
     } else {
@@ -6803,7 +7303,19 @@ void game::fling_player_or_monster(player *p, monster *zz, int dir, int flvel)
         std::string dname;
         bool thru = true;
         bool slam = false;
+// A monster sharing the square with someone is hit first, as it always was
         int mondex = mon_at(x, y);
+        player *ph = NULL;
+        if (mondex < 0)
+        {
+            creature_ref hit = creature_at(x, y);
+            if (hit.type == CREATURE_PLAYER)
+                ph = &u;
+            else if (hit.type == CREATURE_NPC)
+                ph = &active_npc[hit.index];
+            if (ph == p)
+                ph = NULL;
+        }
         dam1 = flvel / 3 + rng (0, flvel * 1 / 3);
         if (mondex >= 0)
         {
@@ -6818,6 +7330,18 @@ void game::fling_player_or_monster(player *p, monster *zz, int dir, int flvel)
              p->hitall (this, dam1, 40);
             else
                 zz->hurt(dam1);
+        } else if (ph)
+        {
+// People are never killed outright, so they always stop the fling
+            slam = true;
+            dname = (ph == &u ? std::string("you") : ph->name);
+            dam2 = flvel / 3 + rng (0, flvel * 1 / 3);
+            ph->hitall (this, dam2, 40);
+            thru = false;
+            if (is_player)
+                p->hitall (this, dam1, 40);
+            else
+                zz->hurt(dam1);
         } else if (m.move_cost(x, y) == 0 && !m.has_flag(swimmable, x, y)) {
             slam = true;
             int vpart;
@@ -6835,7 +7359,9 @@ void game::fling_player_or_monster(player *p, monster *zz, int dir, int flvel)
                 zz->hurt (dam1);
             flvel = flvel / 2;
         }
-        if (slam)
+        if (slam && ph)
+            add_msg ("%s slammed against %s for %d damage!", sname.c_str(), dname.c_str(), dam1);
+        else if (slam)
             add_msg ("%s slammed against the %s for %d damage!", sname.c_str(), dname.c_str(), dam1);
         if (thru)
         {
@@ -6846,8 +7372,7 @@ void game::fling_player_or_monster(player *p, monster *zz, int dir, int flvel)
             }
             else
             {
-                zz->posx = x;
-                zz->posy = y;
+                zz->setpos(this, x, y);
             }
         }
         else
@@ -6978,29 +7503,21 @@ void game::vertical_move(int movez, bool force)
     int turns = z[i].turns_to_reach(this, u.posx, u.posy);
     if (turns < 999)
      coming_to_stairs.push_back( monster_and_count(z[i], 1 + turns) );
-   } else if (z[i].spawnmapx != -1) { // Static spawn, move them back there
-    tinymap tmp(&itypes, &mapitems, &traps);
-    tmp.load(this, z[i].spawnmapx, z[i].spawnmapy, false);
-    tmp.add_spawn(&(z[i]));
-    tmp.save(&cur_om, turn, z[i].spawnmapx, z[i].spawnmapy);
-   } else if (z[i].friendly < 0) { // Friendly, make it into a static spawn
-    tinymap tmp(&itypes, &mapitems, &traps);
-    tmp.load(this, levx, levy, false);
-    int spawnx = z[i].posx, spawny = z[i].posy;
-    while (spawnx < 0)
-     spawnx += SEEX;
-    while (spawny < 0)
-     spawny += SEEY;
-    tmp.add_spawn(&(z[i]));
-    tmp.save(&cur_om, turn, levx, levy);
-   } else {
+   } else if (z[i].spawnmapx != -1) // Static spawn, move them back there
+    despawn(z[i], z[i].spawnmapx, z[i].spawnmapy);
+   else if (z[i].friendly < 0) // Friendly, make it into a static spawn
+    despawn(z[i], levx, levy);
+   else {
     int group = valid_group( (mon_id)(z[i].type->id), levx, levy);
     if (group != -1)
      cur_om.zg[group].population++;
    }
   }
+  flush_despawns();
  }
  z.clear();
+ monmap_changed();
+ sounds.clear(); // Made on the level we're leaving
 
 // Figure out where we know there are up/down connectors
  std::vector<point> discover;
@@ -7036,11 +7553,11 @@ void game::vertical_move(int movez, bool force)
  u.posx = stairx;
  u.posy = stairy;
  if (rope_ladder)
-  m.ter(u.posx, u.posy) = t_rope_up;
+  m.ter_set(u.posx, u.posy, t_rope_up);
  if (m.ter(stairx, stairy) == t_manhole_cover) {
   m.add_item(stairx + rng(-1, 1), stairy + rng(-1, 1),
              itypes[itm_manhole_cover], 0);
-  m.ter(stairx, stairy) = t_manhole;
+  m.ter_set(stairx, stairy, t_manhole);
  }
 
  if (replace_monsters)
@@ -7121,17 +7638,16 @@ void game::update_map(int &x, int &y)
  set_adjacent_overmaps();
 
  // Shift monsters
+ monmap_changed();
+ clear_claims();
  for (int i = 0; i < z.size(); i++) {
   z[i].shift(shiftx, shifty);
   if (z[i].posx < 0 - SEEX             || z[i].posy < 0 - SEEX ||
       z[i].posx > SEEX * (MAPSIZE + 1) || z[i].posy > SEEY * (MAPSIZE + 1)) {
 // Despawn; we're out of bounds
-   if (z[i].spawnmapx != -1) {	// Static spawn, move them back there
-    map tmp(&itypes, &mapitems, &traps);
-    tmp.load(this, z[i].spawnmapx, z[i].spawnmapy, false);
-    tmp.add_spawn(&(z[i]));
-    tmp.save(&cur_om, turn, z[i].spawnmapx, z[i].spawnmapy);
-   } else {	// Absorb them back into a group
+   if (z[i].spawnmapx != -1)	// Static spawn, move them back there
+    despawn(z[i], z[i].spawnmapx, z[i].spawnmapy);
+   else {	// Absorb them back into a group
     group = valid_group((mon_id)(z[i].type->id), levx + shiftx, levy + shifty);
     if (group != -1) {
      cur_om.zg[group].population++;
@@ -7145,10 +7661,12 @@ void game::update_map(int &x, int &y)
                                   levx + shiftx, levy + shifty, 1, 1));
 */
    }
-   z.erase(z.begin()+i);
+   z.remove(i);
+   monmap_changed();
    i--;
   }
  }
+ flush_despawns();
 // Shift NPCs
  for (int i = 0; i < active_npc.size(); i++) {
   active_npc[i].shift(shiftx, shifty);
@@ -7215,7 +7733,8 @@ void game::update_map(int &x, int &y)
  m.spawn_monsters(this);	// Static monsters
  if (turn >= nextspawn)
   spawn_mon(shiftx, shifty);
-// Shift scent
+// Shift the sounds waiting to be heard, and the scent
+ sounds.shift(shiftx * SEEX, shifty * SEEY);
  unsigned int newscent[SEEX * MAPSIZE][SEEY * MAPSIZE];
  for (int i = 0; i < SEEX * MAPSIZE; i++) {
   for (int j = 0; j < SEEY * MAPSIZE; j++)
@@ -7445,7 +7964,7 @@ void game::spawn_mon(int shiftx, int shifty)
     nextspawn += rng(group * 4 + z.size() * 4, group * 10 + z.size() * 10);
 
    for (int j = 0; j < group; j++) {	// For each monster in the group...
-    mon_id type = valid_monster_from(moncats[cur_om.zg[i].type]);
+    mon_id type = valid_monster_from(cur_om.zg[i].type);
     if (type == mon_null)
      j = group;	// No monsters may be spawned; not soon enough?
     else {
@@ -7489,28 +8008,81 @@ void game::spawn_mon(int shiftx, int shifty)
  }
 }
 
-mon_id game::valid_monster_from(std::vector<mon_id> group)
+// Monsters join a category's table once the game's old enough for them, so
+// each table only needs rebuilding when the turn passes one of those
+// thresholds.  The weights keep the odds of the cumulative walk this replaced,
+// which drew from [0, total) and stopped at the first running total that
+// reached the draw: one extra chance for the first, one fewer for the last.
+mon_id game::valid_monster_from(moncat_id cat)
+{
+ moncat_picks &table = moncat_tables[cat];
+ const int now = int(turn);
+ if (now < table.from || now >= table.until) {
+  const std::vector<mon_id> &group = moncats[cat];
+  table.mons.clear();
+  table.from = INT_MIN;
+  table.until = INT_MAX;
+  std::vector<int> weights;
+  int running = -1, total = 0;
+  for (int i = 0; i < group.size(); i++) {
+   if (mtypes[group[i]]->frequency <= 0)
+    continue;
+   const int joins = MINUTES(STARTING_MINUTES) +
+                     HOURS(mtypes[group[i]]->difficulty) - 900;
+   if (now >= joins) {
+    table.mons.push_back(group[i]);
+    weights.push_back(mtypes[group[i]]->frequency);
+    total += mtypes[group[i]]->frequency;
+    if (joins > table.from)
+     table.from = joins;
+   } else if (joins < table.until)
+    table.until = joins;
+  }
+  for (int i = 0; i < weights.size(); i++) {
+   const int before = running;
+   running += weights[i] + (i == 0 ? 1 : 0);
+   weights[i] = (running < total - 1 ? running : total - 1) - before;
+  }
+  table.picks = alias_table(weights);
+ }
+ if (table.mons.empty())
+  return mon_null;
+ return table.mons[table.picks.pick()];
+}
+
+
+void game::despawn(monster &mon, int smx, int smy)
 {
- std::vector<mon_id> valid;
- int rntype = 0;
- for (int i = 0; i < group.size(); i++) {
-  if (mtypes[group[i]]->frequency > 0 &&
-      int(turn) + 900 >=
-          MINUTES(STARTING_MINUTES) + HOURS(mtypes[group[i]]->difficulty)){
-   valid.push_back(group[i]);
-   rntype += mtypes[group[i]]->frequency;
+ tripoint sm(cur_om.posx * OMAPX * 2 + smx, cur_om.posy * OMAPY * 2 + smy,
+             cur_om.posz);
+ despawns[sm].push_back(map::spawn_from(&mon));
+}
+
+// The submaps monsters spawned from are nearly always still in the mapbuffer,
+// so they can be added to in place; only one that's somehow gone missing needs
+// a map loaded to bring it back.
+void game::flush_despawns()
+{
+ std::map<tripoint, std::vector<spawn_point>, pointcomp>::iterator it;
+ for (it = despawns.begin(); it != despawns.end(); it++) {
+  const tripoint &p = it->first;
+  submap *sm = MAPBUFFER.lookup_submap(p.x, p.y, p.z);
+  if (sm == NULL) {
+   const int smx = p.x - cur_om.posx * OMAPX * 2,
+             smy = p.y - cur_om.posy * OMAPY * 2;
+   tinymap tmp(&itypes, &mapitems, &traps);
+   tmp.load(this, smx, smy, false);
+   tmp.save(&cur_om, turn, smx, smy);
+   sm = MAPBUFFER.lookup_submap(p.x, p.y, p.z);
+   if (sm == NULL) {
+    debugmsg("Couldn't load submap %d:%d:%d to despawn %d monsters onto",
+             p.x, p.y, p.z, it->second.size());
+    continue;
+   }
   }
+  sm->spawns.insert(sm->spawns.end(), it->second.begin(), it->second.end());
  }
- if (valid.size() == 0)
-  return mon_null;
- int curmon = -1;
- if (rntype > 0)
-  rntype = rng(0, rntype - 1);	// rntype set to [0, rntype)
- do {
-  curmon++;
-  rntype -= mtypes[valid[curmon]]->frequency;
- } while (rntype > 0);
- return valid[curmon];
+ despawns.clear();
 }
 
 
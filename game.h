@@ -3,8 +3,12 @@
 
 #include "mtype.h"
 #include "monster.h"
+#include "monlist.h"
 #include "map.h"
+#include "mapbuffer.h"
 #include "lightmap.h"
+#include "soundmap.h"
+#include "scent.h"
 #include "player.h"
 #include "overmap.h"
 #include "omdata.h"
@@ -33,6 +37,9 @@
 #define EXPLOSION_SPEED 70000000
 
 #define PICKUP_RANGE 2
+#define SCENT_RADIUS 18 // Scent spreads this far around the player each turn
+#define SCENT_FAR_COLUMNS 4 // ...and over this many columns of submaps further out
+#define MON_AI_RADIUS 24 // Monsters this close to the player always get full AI
 
 enum tut_type {
  TUT_NULL,
@@ -55,6 +62,30 @@ enum quit_status {
  QUIT_DELETE_WORLD  // Quit and delete world 
 };
 
+enum creature_type {
+ CREATURE_NONE = 0,
+ CREATURE_PLAYER,  // g->u
+ CREATURE_NPC,     // An index into g->active_npc
+ CREATURE_MONSTER  // An index into g->z
+};
+
+struct creature_ref
+{
+ creature_type type;
+ int index; // -1 for CREATURE_NONE and CREATURE_PLAYER
+ creature_ref(creature_type T = CREATURE_NONE, int I = -1) : type (T), index (I) {};
+ bool empty() const { return type == CREATURE_NONE; };
+};
+
+// What monster::plan() works in besides the monster itself.  Each planning
+// job has its own, so that jobs on different threads write nothing in common;
+// their counts are added to map::target_los_stats afterwards.
+struct plan_scratch
+{
+ std::vector<int> nearby; // For nearest_mons()
+ los_stats los;
+};
+
 struct monster_and_count
 {
  monster mon;
@@ -62,6 +93,16 @@ struct monster_and_count
  monster_and_count(monster M, int C) : mon (M), count (C) {};
 };
 
+// The monsters in a category that are old enough to spawn, weighted by how
+// common they are; good for turns from up to (but not including) until
+struct moncat_picks
+{
+ std::vector<mon_id> mons;
+ alias_table picks;
+ int from, until;
+ moncat_picks() : from(0), until(0) {};
+};
+
 struct game_message
 {
  calendar turn;
@@ -118,8 +159,27 @@ class game
   void emp_blast(int x, int y);
   int  npc_at(int x, int y);	// Index of the npc at (x, y); -1 for none
   int  npc_by_id(int id);	// Index of the npc at (x, y); -1 for none
- // void build_monmap();		// Caches data for mon_at()
   int  mon_at(int x, int y);	// Index of the monster at (x, y); -1 for none
+// mon_at() looks monsters up in monmap.  Monsters added to the end of z are
+// picked up by themselves; anything that moves a monster in z must go
+// through monster::setpos(), and anything that removes or reorders monsters
+// in z must call monmap_changed().
+  void mon_moved(const monster *mon, int oldx, int oldy);
+  void monmap_changed();
+// Indices into z of the live monsters in an area, looked up in monmap
+  std::vector<int> mons_in_rect(int x1, int y1, int x2, int y2);
+  std::vector<int> mons_in_radius(int x, int y, int radius); // By rl_dist()
+  std::vector<int> nearest_mons(int x, int y, int radius, int count = 0);
+// The same, filled into ret, so that callers asking every turn can reuse it
+  void mons_in_rect(int x1, int y1, int x2, int y2, std::vector<int> &ret);
+  void nearest_mons(int x, int y, int radius, std::vector<int> &ret,
+                    int count = 0);
+// Whoever is standing at (x, y), be it the player, an NPC or a monster
+  creature_ref creature_at(int x, int y);
+// Reserves (x, y) for a creature that means to move there this turn; false if
+// someone else got there first.  Claims lapse at the end of the turn.
+  bool claim(int x, int y);
+  bool claimed(int x, int y);
   bool is_empty(int x, int y);	// True if no PC, no monster, move cost > 0
   bool isBetween(int test, int down, int up);
   bool is_in_sunlight(int x, int y); // Checks outdoors + sunny
@@ -162,7 +222,7 @@ class game
 
   void nuke(int x, int y);
   std::vector<faction *> factions_at(int x, int y);
-  int& scent(int x, int y);
+  short& scent(int x, int y);
   float natural_light_level();
   unsigned char light_level();
   void reset_light_level();
@@ -170,6 +230,8 @@ class game
   int assign_faction_id();
   faction* faction_by_id(int it);
   bool sees_u(int x, int y, int &t);
+  bool sees_u(int x, int y); // As above, from the per-turn LOS cache; no line
+  bool sees_u(int x, int y, los_stats &stats); // Builds no cache; see plan_monsters()
   bool u_see (int x, int y, int &t);
   bool u_see (monster *mon, int &t);
   bool pl_sees(player *p, monster *mon, int &t);
@@ -204,6 +266,7 @@ class game
 
   std::vector <itype_id> mapitems[num_itloc]; // Items at various map types
   std::vector <items_location_and_chance> monitems[num_monsters];
+  alias_table monitem_picks[num_monsters]; // By chance; see init_monitems()
   std::vector <mission_type> mission_types; // The list of mission templates
   mutation_branch mutation_data[PF_MAX2]; // Mutation data
   std::map<char, action_id> keymap;
@@ -215,13 +278,18 @@ class game
   overmap cur_om;
   map m;
   light_map lm;
+  sound_map sounds; // Sounds made this turn that monsters haven't heard yet
   int levx, levy, levz;	// Placement inside the overmap
   player u;
-  std::vector<monster> z;
+  monster_list z;
+  std::vector<int> plan_order; // Indices into z of the monsters planning this turn
+  std::vector<plan_scratch> plan_scratches; // One per planning job
+  plan_scratch replan_scratch; // For monsters planning again as they move
   std::vector<monster_and_count> coming_to_stairs;
   int monstairx, monstairy, monstairz;
   std::vector<npc> active_npc;
   std::vector<mon_id> moncats[num_moncats];
+  moncat_picks moncat_tables[num_moncats]; // See valid_monster_from()
   std::vector<faction> factions;
   std::vector<mission> active_missions; // Missions which may be assigned
 // NEW: Dragging a piece of furniture, with a list of items contained
@@ -327,20 +395,31 @@ class game
 // returns a Bresenham line to that square.  It is called by plfire() and
 // throw().
   std::vector<point> target(int &x, int &y, int lowx, int lowy, int hix,
-                            int hiy, std::vector <monster> t, int &target,
+                            int hiy, const std::vector<int> &t, int &target,
                             item *relevent);
 
 // Map updating and monster spawning
   void replace_stair_monsters();
   void update_stair_monsters();
   void spawn_mon(int shift, int shifty); // Called by update_map, sometimes
-  mon_id valid_monster_from(std::vector<mon_id> group);
+  mon_id valid_monster_from(moncat_id cat);
   int valid_group(mon_id type, int x, int y);// Picks a group from cur_om
+// Static spawns leaving the bubble go back to the submap at (smx, smy), in the
+// same coordinates as levx/levy.  despawn() queues them up, and
+// flush_despawns() adds each submap's batch to it in the mapbuffer.
+  void despawn(monster &mon, int smx, int smy);
+  void flush_despawns();
   moncat_id mt_to_mc(mon_id type);// Monster type to monster category
   void set_adjacent_overmaps(bool from_scratch = false);
 
 // Routine loop functions, approximately in order of execution
   void cleanup_dead();     // Delete any dead NPCs/monsters
+  void hear_sounds();      // Monsters react to queued sounds
+  void plan_monsters();    // Monsters pick where to go, before any of them move
+  static void plan_job(void *data, int index); // See plan_monsters()
+  monster_lod mon_lod(monster &mon); // How much AI a monster needs right now
+  bool mon_thinks(int index); // Whether z[index] plans and moves this turn
+  int mon_lod_count[NUM_MLOD]; // Monsters at each level of detail last turn
   void monmove();          // Monster movement
   void rustCheck();        // Degrades practice levels
   void process_events();   // Processes and enacts long-term events
@@ -350,6 +429,9 @@ class game
   void mon_info();         // Prints a list of nearby monsters (top right)
   input_ret get_input(int timeout_ms);   // Gets player input and calls the proper function
   void update_scent();     // Updates the scent map
+  int diffuse_scent(const int x1, const int y1, const int x2, const int y2); // See update_scent()
+  void add_scent_column(const int column);
+  static void diffuse_scent_job(void *data, int index);
   bool is_game_over();     // Returns true if the player quit or died
   void death_screen();     // Display our stats, "GAME OVER BOO HOO"
   void gameover();         // Ends the game
@@ -380,7 +462,7 @@ class game
 
 // ########################## DATA ################################
 
-  signed char last_target;// The last monster targeted
+  mon_handle last_target;// The last monster targeted
   char run_mode; // 0 - Normal run always; 1 - Running allowed, but if a new
 		 //  monsters spawns, go to 2 - No movement allowed
   int mostseen;	 // # of mons seen last turn; if this increases, run_mode++
@@ -393,9 +475,18 @@ class game
   int next_npc_id, next_faction_id, next_mission_id; // Keep track of UIDs
   std::vector <game_message> messages;   // Messages to be printed
   int curmes;	  // The last-seen message.
-  int grscent[SEEX * MAPSIZE][SEEY * MAPSIZE];	// The scent map
-  //int monmap[SEEX * MAPSIZE][SEEY * MAPSIZE]; // Temp monster map, for mon_at()
-  int nulscent;				// Returned for OOB scent checks
+  short grscent[SEEX * MAPSIZE][SEEY * MAPSIZE];	// The scent map
+  short oldscent[SEEX * MAPSIZE][SEEY * MAPSIZE]; // grscent before this turn's spread
+  int scent_column; // Next column of submaps to spread scent over; see update_scent()
+  std::vector<scent_rect> scent_jobs; // Rectangles to spread this turn
+  int monmap[SEEX * MAPSIZE][SEEY * MAPSIZE]; // Index into z, -1 for none
+  int monmap_size; // How many of z are in monmap; -1 to rebuild it
+  int monmap_count[MAPSIZE][MAPSIZE]; // Squares in each submap with a monster
+  void sync_monmap();
+  int claims[SEEX * MAPSIZE][SEEY * MAPSIZE]; // Turn each square was claimed
+  void clear_claims();
+  std::map<tripoint, std::vector<spawn_point>, pointcomp> despawns; // By submap
+  short nulscent;			// Returned for OOB scent checks
   std::vector<event> events;	        // Game events to be processed
   int kills[num_monsters];	        // Player's kill count
   std::string last_action;		// The keypresses of last turn
@@ -3,6 +3,11 @@
 #include "game.h"
 #include "keypress.h"
 
+inventory::inventory()
+{
+ active_changed = true;
+}
+
 item& inventory::operator[] (int i)
 {
  if (i < 0 || i > items.size()) {
@@ -124,6 +129,7 @@ void inventory::clear()
  }
 */
  items.clear();
+ active_changed = true;
 }
 
 void inventory::add_stack(const std::vector<item> newits)
@@ -144,6 +150,7 @@ void inventory::add_item(item newit, bool keep_invlet)
 
  if (newit.is_style())
   return; // Styles never belong in our inventory.
+ active_changed = true;
  for (int i = 0; i < items.size(); i++) {
   if (items[i][0].stacks_with(newit)) {
 /*
@@ -206,17 +213,22 @@ void inventory::restack(player *p)
 
 void inventory::form_from_map(game *g, point origin, int range)
 {
- items.clear();
- for (int x = origin.x - range; x <= origin.x + range; x++) {
-  for (int y = origin.y - range; y <= origin.y + range; y++) {
-   for (int i = 0; i < g->m.i_at(x, y).size(); i++)
-    if (!g->m.i_at(x, y)[i].made_of(LIQUID))
-     add_item(g->m.i_at(x, y)[i]);
+ clear();
+ map_region reg = g->m.region(origin, range);
+ for (int s = 0; s < reg.size(); s++) {
+  submap *sm = reg[s].sm;
+  for (int lx = reg[s].lx1; lx <= reg[s].lx2; lx++) {
+   for (int ly = reg[s].ly1; ly <= reg[s].ly2; ly++) {
+    std::vector<item> &here = sm->itm[lx][ly];
+    for (int i = 0; i < here.size(); i++)
+     if (!here[i].made_of(LIQUID))
+      add_item(here[i]);
 // Kludge for now!
-   if (g->m.field_at(x, y).type == fd_fire) {
-    item fire(g->itypes[itm_fire], 0);
-    fire.charges = 1;
-    add_item(fire);
+    if (sm->fld[lx][ly].type == fd_fire) {
+     item fire(g->itypes[itm_fire], 0);
+     fire.charges = 1;
+     add_item(fire);
+    }
    }
   }
  }
@@ -232,6 +244,7 @@ std::vector<item> inventory::remove_stack(int index)
  }
  std::vector<item> ret = stack_at(index);
  items.erase(items.begin() + index);
+ active_changed = true;
  return ret;
 }
 
@@ -246,6 +259,7 @@ item inventory::remove_item(int index)
  items[index].erase(items[index].begin());
  if (items[index].empty())
   items.erase(items.begin() + index);
+ active_changed = true;
  return ret;
 }
 
@@ -265,6 +279,7 @@ item inventory::remove_item(int stack, int index)
  items[stack].erase(items[stack].begin() + index);
  if (items[stack].empty())
   items.erase(items.begin() + stack);
+ active_changed = true;
 
  return ret;
 }
@@ -386,6 +401,7 @@ void inventory::use_amount(itype_id it, int quantity, bool use_container)
     j--;
     if (items[i].empty()) {
      items.erase(items.begin() + i);
+     active_changed = true;
      i--;
      j = 0;
     }
@@ -395,6 +411,7 @@ void inventory::use_amount(itype_id it, int quantity, bool use_container)
     j--;
     if (items[i].empty()) {
      items.erase(items.begin() + i);
+     active_changed = true;
      i--;
      j = 0;
     }
@@ -432,6 +449,7 @@ void inventory::use_charges(itype_id it, int quantity)
       j--;
       if (items[i].empty()) {
        items.erase(items.begin() + i);
+       active_changed = true;
        i--;
        j = 0;
       }
@@ -456,6 +474,24 @@ bool inventory::has_charges(itype_id it, int quantity)
  return (charges_of(it) >= quantity);
 }
 
+const std::vector<int>& inventory::active_stacks()
+{
+ if (active_changed) {
+  active.clear();
+  for (int i = 0; i < items.size(); i++) {
+   for (int j = 0; j < items[i].size(); j++) {
+    if (items[i][j].active ||
+        (items[i][j].is_artifact() && items[i][j].is_tool())) {
+     active.push_back(i);
+     break;
+    }
+   }
+  }
+  active_changed = false;
+ }
+ return active;
+}
+
 bool inventory::has_item(item *it)
 {
  for (int i = 0; i < items.size(); i++) {
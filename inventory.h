@@ -11,6 +11,8 @@ class map;
 class inventory
 {
  public:
+  inventory();
+
   item& operator[] (int i);
   std::vector<item>& stack_at(int i);
   std::vector<item> const_stack(int i) const;
@@ -64,6 +66,12 @@ class inventory
   bool has_charges(itype_id it, int quantity);
   bool has_item(item *it); // Looks for a specific item
 
+// Stacks holding an active item or an artifact tool, for
+// player::process_active_items().  Worked out again after anything that adds
+// or removes items; an item switched on in place through operator[] or
+// stack_at() isn't noticed until then (player::use() re-adds the item it used)
+  const std::vector<int>& active_stacks();
+
 /* TODO: This stuff, I guess?
   std::string save();
   void load(std::string data);
@@ -74,6 +82,8 @@ class inventory
  private:
   void assign_empty_invlet(item &it, player *p = NULL);
   std::vector< std::vector<item> > items;
+  std::vector<int> active;
+  bool active_changed; // active needs working out again
 };
 
 #endif
@@ -978,7 +978,7 @@ void iuse::hammer(game *g, player *p, item *it, bool t)
  p->moves -= 500;
  g->m.add_item(p->posx, p->posy, g->itypes[itm_nail], 0, nails);
  g->m.add_item(p->posx, p->posy, g->itypes[itm_2x4], 0, boards);
- g->m.ter(dirx, diry) = newter;
+ g->m.ter_set(dirx, diry, newter);
 }
 
 void iuse::light_off(game *g, player *p, item *it, bool t)
@@ -1193,7 +1193,7 @@ else if (dirx == 0 && diry == 0) {
       if (dice(4, 6) < dice(4, p->dex_cur)) {
    g->add_msg_if_player(p,"You pick the lock and the gate swings open.");
    p->moves -= (400 - (p->dex_cur * 5));
-   g->m.ter(dirx, diry) = t_chaingate_o;
+   g->m.ter_set(dirx, diry, t_chaingate_o);
    return;
   }
  }
@@ -1201,7 +1201,7 @@ else if (dirx == 0 && diry == 0) {
   if (dice(4, 6) < dice(4, p->dex_cur)) {
    g->add_msg_if_player(p,"You pick the lock and the door swings open.");
    p->moves -= (400 - (p->dex_cur * 5));
-   g->m.ter(dirx, diry) = t_door_o;
+   g->m.ter_set(dirx, diry, t_door_o);
    return;
   }
  } else {
@@ -1225,7 +1225,7 @@ void iuse::crowbar(game *g, player *p, item *it, bool t)
   if (dice(4, 6) < dice(4, p->str_cur)) {
    g->add_msg_if_player(p,"You pry the door open.");
    p->moves -= (150 - (p->str_cur * 5));
-   g->m.ter(dirx, diry) = t_door_o;
+   g->m.ter_set(dirx, diry, t_door_o);
       g->sound(dirx, diry, 8, "crunch!");
 
   } else {
@@ -1236,7 +1236,7 @@ void iuse::crowbar(game *g, player *p, item *it, bool t)
   if (dice(8, 8) < dice(8, p->str_cur)) {
    g->add_msg_if_player(p,"You lift the manhole cover.");
    p->moves -= (500 - (p->str_cur * 5));
-   g->m.ter(dirx, diry) = t_manhole;
+   g->m.ter_set(dirx, diry, t_manhole);
    g->m.add_item(p->posx, p->posy, g->itypes[itm_manhole_cover], 0);
   } else {
    g->add_msg_if_player(p,"You pry, but cannot lift the manhole cover.");
@@ -1246,7 +1246,7 @@ void iuse::crowbar(game *g, player *p, item *it, bool t)
   if (p->str_cur >= rng(3, 30)) {
    g->add_msg_if_player(p,"You pop the crate open.");
    p->moves -= (150 - (p->str_cur * 5));
-   g->m.ter(dirx, diry) = t_crate_o;
+   g->m.ter_set(dirx, diry, t_crate_o);
   } else {
    g->add_msg_if_player(p,"You pry, but cannot open the crate.");
    p->moves -= 100;
@@ -1283,7 +1283,7 @@ void iuse::crowbar(game *g, player *p, item *it, bool t)
   p->moves -= 500;
   g->m.add_item(p->posx, p->posy, g->itypes[itm_nail], 0, nails);
   g->m.add_item(p->posx, p->posy, g->itypes[itm_2x4], 0, boards);
-  g->m.ter(dirx, diry) = newter;
+  g->m.ter_set(dirx, diry, newter);
  }
 }
 
@@ -1292,7 +1292,7 @@ void iuse::makemound(game *g, player *p, item *it, bool t)
  if (g->m.has_flag(diggable, p->posx, p->posy)) {
   g->add_msg_if_player(p,"You churn up the earth here.");
   p->moves = -300;
-  g->m.ter(p->posx, p->posy) = t_dirtmound;
+  g->m.ter_set(p->posx, p->posy, t_dirtmound);
  } else
   g->add_msg_if_player(p,"You can't churn up this ground.");
 }
@@ -2535,24 +2535,24 @@ void iuse::hacksaw(game *g, player *p, item *it, bool t)
  diry += p->posy;
  if (g->m.ter(dirx, diry) == t_chainfence_v || g->m.ter(dirx, diry) == t_chainfence_h) {
   p->moves -= 500;
-  g->m.ter(dirx, diry) = t_pavement;
+  g->m.ter_set(dirx, diry, t_pavement);
   g->sound(dirx, diry, 15,"grnd grnd grnd");
   g->m.add_item(dirx, diry, g->itypes[itm_pipe], 0, 6);
   g->m.add_item(dirx, diry, g->itypes[itm_wire], 0, 20);
  } else if (g->m.ter(dirx, diry) == t_rack) {
   p->moves -= 500;
-  g->m.ter(dirx, diry) = t_floor;
+  g->m.ter_set(dirx, diry, t_floor);
   g->sound(dirx, diry, 15,"grnd grnd grnd");
   g->m.add_item(p->posx, p->posy, g->itypes[itm_pipe], 0, rng(1, 3));
   g->m.add_item(p->posx, p->posy, g->itypes[itm_steel_chunk], 0);
  } else if (g->m.ter(dirx, diry) == t_bars && g->m.ter(dirx + 1, diry) == t_sewage ||
                                               g->m.ter(dirx, diry + 1) == t_sewage) {
-  g->m.ter(dirx, diry) = t_sewage;
+  g->m.ter_set(dirx, diry, t_sewage);
   p->moves -= 1000;
   g->sound(dirx, diry, 15,"grnd grnd grnd");
   g->m.add_item(p->posx, p->posy, g->itypes[itm_pipe], 0, 3);
  } else if (g->m.ter(dirx, diry) == t_bars && g->m.ter(p->posx, p->posy)) {
-  g->m.ter(dirx, diry) = t_floor;
+  g->m.ter_set(dirx, diry, t_floor);
   p->moves -= 500;
   g->sound(dirx, diry, 15,"grnd grnd grnd");
   g->m.add_item(p->posx, p->posy, g->itypes[itm_pipe], 0, 3);
@@ -2583,9 +2583,9 @@ void iuse::tent(game *g, player *p, item *it, bool t)
    }
  for (int i = -1; i <= 1; i++)
   for (int j = -1; j <= 1; j++)
-    g->m.ter(posx + i, posy + j) = t_canvas_wall;
- g->m.ter(posx, posy) = t_groundsheet;
- g->m.ter(posx - dirx, posy - diry) = t_canvas_door;
+    g->m.ter_set(posx + i, posy + j, t_canvas_wall);
+ g->m.ter_set(posx, posy, t_groundsheet);
+ g->m.ter_set(posx - dirx, posy - diry, t_canvas_door);
  it->invlet = 0;
 }
 
@@ -2906,12 +2906,12 @@ void iuse::boltcutters(game *g, player *p, item *it, bool t)
  diry += p->posy;
  if (g->m.ter(dirx, diry) == t_chaingate_l) {
   p->moves -= 100;
-  g->m.ter(dirx, diry) = t_chaingate_c;
+  g->m.ter_set(dirx, diry, t_chaingate_c);
   g->sound(dirx, diry, 5, "Gachunk!");
   g->m.add_item(p->posx, p->posy, g->itypes[itm_scrap], 0, 3);
  } else if (g->m.ter(dirx, diry) == t_chainfence_v || g->m.ter(dirx, diry) == t_chainfence_h) {
   p->moves -= 500;
-  g->m.ter(dirx, diry) = t_chainfence_posts;
+  g->m.ter_set(dirx, diry, t_chainfence_posts);
   g->sound(dirx, diry, 5,"Snick, snick, gachunk!");
   g->m.add_item(dirx, diry, g->itypes[itm_wire], 0, 20);
  } else {
@@ -3119,7 +3119,7 @@ void iuse::artifact(game *g, player *p, item *it, bool t)
      g->m.bash(x, y, 40, junk);  // Multibash effect, so that doors &c will fall
      g->m.bash(x, y, 40, junk);
      if (g->m.is_destructable(x, y) && rng(1, 10) >= 3)
-      g->m.ter(x, y) = t_rubble;
+      g->m.ter_set(x, y, t_rubble);
     }
    }
    break;
@@ -2,6 +2,11 @@
 #include "map.h"
 #include "game.h"
 #include "lightmap.h"
+#include <algorithm>
+#include <iterator>
+#include <climits>
+#include <cmath>
+#include <ctime>
 
 #define INBOUNDS(x, y) (x >= -SEEX && x <= SEEX && y >= -SEEY && y <= SEEY)
 #define INBOUNDS_LARGE(x, y) (x >= -LIGHTMAP_RANGE_X && x <= LIGHTMAP_RANGE_X &&\
@@ -10,134 +15,312 @@
 light_map::light_map()
  : lm()
  , sm()
+ , generated(false)
+ , gen_x(0)
+ , gen_y(0)
+ , gen_natural_light(0)
 {
  memset(lm, 0, sizeof(lm));
  memset(sm, 0, sizeof(sm));
+ memset(dirty, 0, sizeof(dirty));
+ memset(lit_by, 0, sizeof(lit_by));
+ lit_gen = 0;
 }
 
+int light_op::range() const
+{
+ if (type == LOP_AMBIENT || luminance <= LIGHT_SOURCE_LOCAL)
+  return 0;
+ return LIGHT_RANGE(luminance);
+}
+
+bool light_op::operator==(const light_op &b) const
+{
+ return type == b.type && x == b.x && y == b.y && angle == b.angle &&
+        luminance == b.luminance;
+}
+
+bool light_op::operator<(const light_op &b) const
+{
+ if (type != b.type)
+  return type < b.type;
+ if (x != b.x)
+  return x < b.x;
+ if (y != b.y)
+  return y < b.y;
+ if (angle != b.angle)
+  return angle < b.angle;
+ return luminance < b.luminance;
+}
+
+// The light map is kept between calls.  When the center and natural light are
+// unchanged, only squares reached by a light that appeared, vanished or
+// changed, or by rays through a square whose transparency changed, are
+// recomputed; a redraw where nothing changed costs just the cache rebuild.
 void light_map::generate(game* g, int x, int y, float natural_light, float luminance)
 {
+ if (generated) {
+  memcpy(prev_outside, outside_cache, sizeof(prev_outside));
+  for (int i = 0; i < LIGHTMAP_CACHE_X; ++i) {
+   for (int j = 0; j < LIGHTMAP_CACHE_Y; ++j)
+    prev_transparency[i][j] = c[i][j].transparency;
+  }
+ }
  build_light_cache(g, x, y);
- memset(lm, 0, sizeof(lm));
- memset(sm, 0, sizeof(sm));
+ std::vector<light_op> old_ops;
+ old_ops.swap(ops);
+ build_ops(g, x, y, natural_light, luminance);
+
+ if (!generated || x != gen_x || y != gen_y ||
+     natural_light != gen_natural_light) {
+  memset(dirty, true, sizeof(dirty));
+  stats.full++;
+ } else {
+  memset(dirty, false, sizeof(dirty));
+  if (!mark_dirty(old_ops, x, y)) {
+   stats.skipped++;
+   return;
+  }
+  stats.partial++;
+ }
+ generated = true;
+ gen_x = x;
+ gen_y = y;
+ gen_natural_light = natural_light;
+
+ // Bounds of the squares being redone, to skip lights that can't reach them
+ int dx1 = LIGHTMAP_X, dy1 = LIGHTMAP_Y, dx2 = -1, dy2 = -1;
+ for (int i = 0; i < LIGHTMAP_X; ++i) {
+  for (int j = 0; j < LIGHTMAP_Y; ++j) {
+   if (!dirty[i][j])
+    continue;
+   dx1 = std::min(dx1, i); dx2 = std::max(dx2, i);
+   dy1 = std::min(dy1, j); dy2 = std::max(dy2, j);
+   lm[i][j] = 0;
+   sm[i][j] = 0;
+   // Daylight vision handling returned back to map due to issues it causes here
+   // In bright light indoor light exists to some degree
+   if (natural_light > LIGHT_SOURCE_BRIGHT &&
+       !is_outside(i - SEEX + LIGHTMAP_RANGE_X, j - SEEY + LIGHTMAP_RANGE_Y))
+    lm[i][j] = LIGHT_AMBIENT_LOW;
+  }
+ }
+ dx1 += x - SEEX; dx2 += x - SEEX;
+ dy1 += y - SEEY; dy2 += y - SEEY;
+
+ for (int i = 0; i < ops.size(); ++i) {
+  const light_op &op = ops[i];
+  const int range = op.range();
+  if (op.x + range < dx1 || op.x - range > dx2 ||
+      op.y + range < dy1 || op.y - range > dy2)
+   continue;
+  switch (op.type) {
+   case LOP_AMBIENT:
+    if (dirty[op.x - x + SEEX][op.y - y + SEEY])
+     lm[op.x - x + SEEX][op.y - y + SEEY] = op.luminance;
+    break;
+   case LOP_SOURCE:
+    apply_light_source(op.x, op.y, x, y, op.luminance);
+    break;
+   case LOP_ARC:
+    apply_light_arc(op.x, op.y, op.angle, x, y, op.luminance);
+    break;
+  }
+ }
+}
 
+// Lists every light affecting the map centered on (x, y), in the order they
+// are applied.
+void light_map::build_ops(game* g, int x, int y, float natural_light, float luminance)
+{
  int dir_x[] = { 1, 0 , -1,  0 };
  int dir_y[] = { 0, 1 ,  0, -1 };
  int dir_d[] = { 180, 270, 0, 90 };
 
- // Daylight vision handling returned back to map due to issues it causes here
- if (natural_light > LIGHT_SOURCE_BRIGHT) {
-  // Apply sunlight, first light source so just assign
-  for(int sx = x - SEEX; sx <= x + SEEX; ++sx) {
-   for(int sy = y - SEEY; sy <= y + SEEY; ++sy) {
-    // In bright light indoor light exists to some degree
-    if (!is_outside(sx - x + LIGHTMAP_RANGE_X, sy - y + LIGHTMAP_RANGE_Y))
-     lm[sx - x + SEEX][sy - y + SEEY] = LIGHT_AMBIENT_LOW;
-   }
-  }
- }
-
  // Apply player light sources
  if (luminance > LIGHT_AMBIENT_LOW)
-  apply_light_source(g->u.posx, g->u.posy, x, y, luminance);
-
- for(int sx = x - LIGHTMAP_RANGE_X; sx <= x + LIGHTMAP_RANGE_X; ++sx) {
-  for(int sy = y - LIGHTMAP_RANGE_Y; sy <= y + LIGHTMAP_RANGE_Y; ++sy) {
-   const ter_id terrain = g->m.ter(sx, sy);
-   const std::vector<item> items = g->m.i_at(sx, sy);
-   const field current_field = g->m.field_at(sx, sy);
-   // When underground natural_light is 0, if this changes we need to revisit
-   if (natural_light > LIGHT_AMBIENT_LOW) {
+  ops.push_back(light_op(LOP_SOURCE, g->u.posx, g->u.posy, luminance));
+
+ // When underground natural_light is 0, if this changes we need to revisit
+ if (natural_light > LIGHT_AMBIENT_LOW) {
+  for(int sx = x - LIGHTMAP_RANGE_X; sx <= x + LIGHTMAP_RANGE_X; ++sx) {
+   for(int sy = y - LIGHTMAP_RANGE_Y; sy <= y + LIGHTMAP_RANGE_Y; ++sy) {
     if (!is_outside(sx - x + LIGHTMAP_RANGE_X, sy - y + LIGHTMAP_RANGE_Y)) {
      // Apply light sources for external/internal divide
      for(int i = 0; i < 4; ++i) {
       if (INBOUNDS_LARGE(sx - x + dir_x[i], sy - y + dir_y[i]) &&
           is_outside(sx - x + LIGHTMAP_RANGE_X + dir_x[i], sy - y + LIGHTMAP_RANGE_Y + dir_y[i])) {
        if (INBOUNDS(sx - x, sy - y) && is_outside(LIGHTMAP_RANGE_X, LIGHTMAP_RANGE_Y))
-        lm[sx - x + SEEX][sy - y + SEEY] = natural_light;
+        ops.push_back(light_op(LOP_AMBIENT, sx, sy, natural_light));
        
        if (c[sx - x + LIGHTMAP_RANGE_X][sy - y + LIGHTMAP_RANGE_Y].transparency > LIGHT_TRANSPARENCY_SOLID)
-       	apply_light_arc(sx, sy, dir_d[i], x, y, natural_light);
+        ops.push_back(light_op(LOP_ARC, sx, sy, natural_light, dir_d[i]));
       }
      }
     }
    }
+  }
+ }
 
+ // Light emitters on the map, from each submap's list of them
+ map_region reg = g->m.region(x - LIGHTMAP_RANGE_X, y - LIGHTMAP_RANGE_Y,
+                              x + LIGHTMAP_RANGE_X, y + LIGHTMAP_RANGE_Y);
+ for(int s = 0; s < reg.size(); ++s) {
+  submap *sub = reg[s].sm;
+  for(int l = 0; l < sub->lights.size(); ++l) {
+   const int lx = sub->lights[l].x, ly = sub->lights[l].y;
+   if (!g->m.light_emitter_at(sub, lx, ly)) {
+    // The light went out or was carried off
+    sub->lights.erase(sub->lights.begin() + l);
+    --l;
+    continue;
+   }
+   if (lx < reg[s].lx1 || lx > reg[s].lx2 || ly < reg[s].ly1 || ly > reg[s].ly2)
+    continue;
+   const int sx = reg[s].x + lx, sy = reg[s].y + ly;
+   const ter_id terrain = sub->ter[lx][ly];
+   const std::vector<item> &items = sub->itm[lx][ly];
+   const field &current_field = sub->fld[lx][ly];
    if (items.size() == 1 &&
        items[0].type->id == itm_flashlight_on)
-    apply_light_source(sx, sy, x, y, 20);
-   
+    ops.push_back(light_op(LOP_SOURCE, sx, sy, 20));
+  
    if(terrain == t_lava)
-    apply_light_source(sx, sy, x, y, 50);
-   
+    ops.push_back(light_op(LOP_SOURCE, sx, sy, 50));
+  
    if(terrain == t_console)
-    apply_light_source(sx, sy, x, y, 3);
+    ops.push_back(light_op(LOP_SOURCE, sx, sy, 3));
 
    if (items.size() == 1 &&
        items[0].type->id == itm_candle_lit)
-    apply_light_source(sx, sy, x, y, 4);
+    ops.push_back(light_op(LOP_SOURCE, sx, sy, 4));
 
    if(terrain == t_emergency_light)
-    apply_light_source(sx, sy, x, y, 3);
+    ops.push_back(light_op(LOP_SOURCE, sx, sy, 3));
 
    // TODO: [lightmap] Attach light brightness to fields
    switch(current_field.type) {
     case fd_fire:
      if (3 == current_field.density)
-      apply_light_source(sx, sy, x, y, 160);
+      ops.push_back(light_op(LOP_SOURCE, sx, sy, 160));
      else if (2 == current_field.density)
-      apply_light_source(sx, sy, x, y, 60);
+      ops.push_back(light_op(LOP_SOURCE, sx, sy, 60));
      else
-      apply_light_source(sx, sy, x, y, 16);
+      ops.push_back(light_op(LOP_SOURCE, sx, sy, 16));
      break;
     case fd_fire_vent:
     case fd_flame_burst:
-     apply_light_source(sx, sy, x, y, 8);
+     ops.push_back(light_op(LOP_SOURCE, sx, sy, 8));
      break;
     case fd_electricity:
      if (3 == current_field.density)
-      apply_light_source(sx, sy, x, y, 8);
+      ops.push_back(light_op(LOP_SOURCE, sx, sy, 8));
      else if (2 == current_field.density)
-      apply_light_source(sx, sy, x, y, 1);
+      ops.push_back(light_op(LOP_SOURCE, sx, sy, 1));
      else
-      apply_light_source(sx, sy, x, y, LIGHT_SOURCE_LOCAL);  // kinda a hack as the square will still get marked
+      ops.push_back(light_op(LOP_SOURCE, sx, sy, LIGHT_SOURCE_LOCAL));  // kinda a hack as the square will still get marked
      break;
    }
+  }
+ }
 
-   // Apply any vehicle light sources
-   if (c[sx - x + LIGHTMAP_RANGE_X][sy - y + LIGHTMAP_RANGE_Y].veh &&
-       c[sx - x + LIGHTMAP_RANGE_X][sy - y + LIGHTMAP_RANGE_Y].veh_light > LL_DARK) {
-    if (c[sx - x + LIGHTMAP_RANGE_X][sy - y + LIGHTMAP_RANGE_Y].veh_light > LL_LIT) {
-     int dir = c[sx - x + LIGHTMAP_RANGE_X][sy - y + LIGHTMAP_RANGE_Y].veh->face.dir();
-     float luminance = c[sx - x + LIGHTMAP_RANGE_X][sy - y + LIGHTMAP_RANGE_Y].veh_light;
-     apply_light_arc(sx, sy, dir, x, y, luminance);
-    }
-   }
+ // Apply any vehicle light sources
+ for(int i = 0; i < veh_lights.size(); ++i) {
+  const light_map_cache &vc = c[veh_lights[i].x][veh_lights[i].y];
+  if (vc.veh_light > LL_LIT) {
+   const int sx = veh_lights[i].x - LIGHTMAP_RANGE_X + x;
+   const int sy = veh_lights[i].y - LIGHTMAP_RANGE_Y + y;
+   ops.push_back(light_op(LOP_ARC, sx, sy, vc.veh_light, vc.veh->face.dir()));
+  }
+ }
 
-   if (c[sx - x + LIGHTMAP_RANGE_X][sy - y + LIGHTMAP_RANGE_Y].mon >= 0) {
-    if (g->z[c[sx - x + LIGHTMAP_RANGE_X][sy - y + LIGHTMAP_RANGE_Y].mon].has_effect(ME_ONFIRE))
-     apply_light_source(sx, sy, x, y, 3);
-
-    // TODO: [lightmap] Attach natural light brightness to creatures
-    // TODO: [lightmap] Allow creatures to have light attacks (ie: eyebot)
-    // TODO: [lightmap] Allow creatures to have facing and arc lights
-    switch(g->z[c[sx - x + LIGHTMAP_RANGE_X][sy - y + LIGHTMAP_RANGE_Y].mon].type->id) {
-     case mon_zombie_electric:
-      apply_light_source(sx, sy, x, y, 1);
-      break;
-     case mon_turret:
-      apply_light_source(sx, sy, x, y, 2);
-      break;
-     case mon_flaming_eye:
-      apply_light_source(sx, sy, x, y, LIGHT_SOURCE_BRIGHT);
-      break;
-     case mon_manhack:
-      apply_light_source(sx, sy, x, y, LIGHT_SOURCE_LOCAL);
-      break;
-    }
+ for(int i = 0; i < g->z.size(); ++i) {
+  const int sx = g->z[i].posx, sy = g->z[i].posy;
+  if (!INBOUNDS(sx - x, sy - y))
+   continue;
+  if (g->z[i].has_effect(ME_ONFIRE))
+   ops.push_back(light_op(LOP_SOURCE, sx, sy, 3));
+
+  // TODO: [lightmap] Attach natural light brightness to creatures
+  // TODO: [lightmap] Allow creatures to have light attacks (ie: eyebot)
+  // TODO: [lightmap] Allow creatures to have facing and arc lights
+  switch(g->z[i].type->id) {
+   case mon_zombie_electric:
+    ops.push_back(light_op(LOP_SOURCE, sx, sy, 1));
+    break;
+   case mon_turret:
+    ops.push_back(light_op(LOP_SOURCE, sx, sy, 2));
+    break;
+   case mon_flaming_eye:
+    ops.push_back(light_op(LOP_SOURCE, sx, sy, LIGHT_SOURCE_BRIGHT));
+    break;
+   case mon_manhack:
+    ops.push_back(light_op(LOP_SOURCE, sx, sy, LIGHT_SOURCE_LOCAL));
+    break;
+  }
+ }
+}
+
+// Marks the squares whose light may differ from the last generate() and
+// returns whether there were any.
+bool light_map::mark_dirty(const std::vector<light_op> &old_ops, int cx, int cy)
+{
+ bool any = false;
+
+ // Lights that appeared, went away or changed.  Both lists come out of
+ // build_ops() in the same order, so what they share is applied in the same
+ // order as before.
+ if (old_ops != ops) {
+  std::vector<light_op> was(old_ops), now(ops), changed;
+  std::sort(was.begin(), was.end());
+  std::sort(now.begin(), now.end());
+  std::set_symmetric_difference(was.begin(), was.end(), now.begin(), now.end(),
+                                std::back_inserter(changed));
+  for (int i = 0; i < changed.size(); ++i)
+   mark_dirty_box(changed[i], cx, cy);
+  any = true;
+ }
+
+ // Squares that turned opaque or clear change every ray through them
+ std::vector<point> blocked;
+ for (int i = 0; i < LIGHTMAP_CACHE_X; ++i) {
+  for (int j = 0; j < LIGHTMAP_CACHE_Y; ++j) {
+   if (c[i][j].transparency != prev_transparency[i][j])
+    blocked.push_back(point(i - LIGHTMAP_RANGE_X + cx, j - LIGHTMAP_RANGE_Y + cy));
+   if (outside_cache[i][j] != prev_outside[i][j] &&
+       INBOUNDS(i - LIGHTMAP_RANGE_X, j - LIGHTMAP_RANGE_Y)) {
+    dirty[i - LIGHTMAP_RANGE_X + SEEX][j - LIGHTMAP_RANGE_Y + SEEY] = true;
+    any = true;
    }
   }
  }
+ if (blocked.size() > LIGHTMAP_X) { // Cheaper to start over
+  memset(dirty, true, sizeof(dirty));
+  return true;
+ }
+ for (int i = 0; i < ops.size(); ++i) {
+  const int range = ops[i].range();
+  for (int j = 0; j < blocked.size(); ++j) {
+   if (abs(blocked[j].x - ops[i].x) <= range &&
+       abs(blocked[j].y - ops[i].y) <= range) {
+    mark_dirty_box(ops[i], cx, cy);
+    any = true;
+    break;
+   }
+  }
+ }
+ return any;
+}
+
+void light_map::mark_dirty_box(const light_op &op, int cx, int cy)
+{
+ const int range = op.range();
+ const int x1 = std::max(op.x - range - cx, -SEEX), x2 = std::min(op.x + range - cx, SEEX);
+ const int y1 = std::max(op.y - range - cy, -SEEY), y2 = std::min(op.y + range - cy, SEEY);
+ for (int i = x1; i <= x2; ++i) {
+  for (int j = y1; j <= y2; ++j)
+   dirty[i + SEEX][j + SEEY] = true;
+ }
 }
 
 lit_level light_map::at(int dx, int dy)
@@ -225,15 +408,275 @@ bool light_map::sees(int fx, int fy, int tx, int ty, int max_range)
  return (x == tx && y == ty);
 }
 
+// Transforms from octant-local (col, row) to map offsets, as in map::build_fov()
+static const int light_mult[4][8] = {
+ {1,  0,  0, -1, -1,  0,  0,  1},
+ {0,  1, -1,  0,  0, -1,  1,  0},
+ {0,  1,  1,  0,  0, -1, -1,  0},
+ {1,  0,  0,  1, -1,  0,  0, -1}
+};
+
+// Degrees between two headings, 0 to 180
+static int angle_between(int a, int b)
+{
+ int diff = abs(a - b) % 360;
+ return (diff > 180 ? 360 - diff : diff);
+}
+
+// Heading of (dx, dy) in degrees, clockwise from east as vehicles face
+static int heading_of(int dx, int dy)
+{
+ int angle = int(floor(atan2(double(dy), double(dx)) * 180 / M_PI + 0.5));
+ return (angle < 0 ? angle + 360 : angle);
+}
+
+// Whether (dx, dy) from the light is within 45 degrees of its heading
+static bool in_arc(const light_map::light_cast &lc, int dx, int dy)
+{
+ const float along = dx * lc.arc_x + dy * lc.arc_y;
+ // cos(45)^2 is 1/2; the slack keeps squares right on the edge lit
+ return along > 0 && 2 * along * along >= (dx * dx + dy * dy) * 0.999f;
+}
+
+// Narrows an octant's slopes, start down to end, to those of rays that can
+// reach the on-screen part of the light map; squares off those rays can
+// neither be seen nor shade anything that can.  Returns false if none can.
+static bool clip_to_view(const light_map::light_cast &lc, float &start, float &end)
+{
+ if (INBOUNDS(lc.x - lc.cx, lc.y - lc.cy))
+  return true;
+ float lo = 1.0f, hi = 0.0f;
+ bool ahead = false;
+ for (int i = 0; i < 4; i++) {
+  // Corners of the light map, out to the edges of its squares
+  const float X = lc.cx - lc.x + (i & 1 ? SEEX + 0.5f : -SEEX - 0.5f);
+  const float Y = lc.cy - lc.y + (i & 2 ? SEEY + 0.5f : -SEEY - 0.5f);
+  // Into octant-local (col, row); the transform's inverse is its transpose
+  const float col = X * lc.xx + Y * lc.yx;
+  float row = X * lc.xy + Y * lc.yy;
+  if (row >= 0) // Behind the light; the nearest row ahead bounds the slope
+   row = -0.5f;
+  else
+   ahead = true;
+  lo = std::min(lo, col / row);
+  hi = std::max(hi, col / row);
+ }
+ if (!ahead || lo > start || hi < end)
+  return false;
+ start = std::min(start, hi);
+ end = std::max(end, lo);
+ return true;
+}
+
 void light_map::apply_light_source(int x, int y, int cx, int cy, float luminance)
+{
+ if (INBOUNDS(x - cx, y - cy) && dirty[x - cx + SEEX][y - cy + SEEY]) {
+  lm[x - cx + SEEX][y - cy + SEEY] += std::max(luminance, static_cast<float>(LL_LOW));
+  sm[x - cx + SEEX][y - cy + SEEY] += luminance;
+ }
+
+ if (luminance > LIGHT_SOURCE_LOCAL) {
+  light_cast lc = { x, y, cx, cy, LIGHT_RANGE(luminance), 0, 0, 0, 0, luminance,
+                    false, 0, 0 };
+  next_lit_gen();
+  for (int oct = 0; oct < 8; oct++) {
+   lc.xx = light_mult[0][oct]; lc.xy = light_mult[1][oct];
+   lc.yx = light_mult[2][oct]; lc.yy = light_mult[3][oct];
+   float start = 1.0f, end = 0.0f;
+   if (clip_to_view(lc, start, end))
+    cast_light(lc, 1, start, end, LIGHT_TRANSPARENCY_CLEAR);
+  }
+ }
+}
+
+// Lights the 90 degrees centered on angle
+void light_map::apply_light_arc(int x, int y, int angle, int cx, int cy, float luminance)
+{
+ if (luminance <= LIGHT_SOURCE_LOCAL)
+  return;
+
+ apply_light_source(x, y, cx, cy, LIGHT_SOURCE_LOCAL);
+
+ // Normalise (should work with negative values too)
+ angle = ((angle % 360) + 360) % 360;
+
+ const float rad = angle * M_PI / 180;
+ light_cast lc = { x, y, cx, cy, LIGHT_RANGE(luminance), 0, 0, 0, 0, luminance,
+                   false, float(cos(rad)), float(sin(rad)) };
+ next_lit_gen();
+ for (int oct = 0; oct < 8; oct++) {
+  lc.xx = light_mult[0][oct]; lc.xy = light_mult[1][oct];
+  lc.yx = light_mult[2][oct]; lc.yy = light_mult[3][oct];
+  // The octant runs from its axis, local (0, -1), to its diagonal, (-1, -1)
+  const bool axis_in = angle_between(heading_of(-lc.xy, -lc.yy), angle) <= 45;
+  const bool diag_in = angle_between(heading_of(-lc.xx - lc.xy, -lc.yx - lc.yy),
+                                     angle) <= 45;
+  if (!axis_in && !diag_in)
+   continue; // The arc is wider than an octant, so it can't fall between
+  // Only octants cut by the edge of the arc check each square, and only
+  // scan the slopes on the lit side of that edge
+  lc.arc = !(axis_in && diag_in);
+  float start = 1.0f, end = 0.0f;
+  for (int e = -45; lc.arc && e <= 45; e += 90) {
+   const float ex = cos(rad + e * M_PI / 180), ey = sin(rad + e * M_PI / 180);
+   // Into octant-local (col, row); the transform's inverse is its transpose
+   const float col = ex * lc.xx + ey * lc.yx, row = ex * lc.xy + ey * lc.yy;
+   if (row < 0 && col <= 0 && col >= row) {
+    if (axis_in)
+     start = col / row;
+    else
+     end = col / row;
+   }
+  }
+  if (clip_to_view(lc, start, end))
+   cast_light(lc, 1, start, end, LIGHT_TRANSPARENCY_CLEAR);
+ }
+}
+
+// Recursive shadowcasting over one octant, like map::cast_fov_octant(), except
+// that squares are lit with distance falloff and a run of translucent squares
+// passes on light dimmed by its transparency instead of blocking it.
+void light_map::cast_light(const light_cast &lc, const int row, float start,
+                           const float end, float cumulative)
+{
+ if (start < end)
+  return;
+ float new_start = 0.0f;
+ for (int j = row; j <= lc.range; j++) {
+  // The row is the distance along the major axis, as with the old rays
+  const float light = lc.luminance / (j * j) * cumulative;
+  float run = -1; // Transparency of the current run of squares in this row
+  const int dy = -j;
+  // Rows only get further from the light map once they leave it
+  const int row_x = lc.x + dy * lc.xy - lc.cx, row_y = lc.y + dy * lc.yy - lc.cy;
+  if ((lc.xy < 0 && row_x > SEEX) || (lc.xy > 0 && row_x < -SEEX) ||
+      (lc.yy < 0 && row_y > SEEY) || (lc.yy > 0 && row_y < -SEEY))
+   break;
+  const float l_inv = 1.0f / (dy + 0.5f), r_inv = 1.0f / (dy - 0.5f);
+  // Skip straight to the first square that can be inside start
+  int dx = std::max(-j, int(floor(start * (dy - 0.5f) - 0.5f))) - 1;
+  while (dx <= 0) {
+   dx++;
+   const int x = lc.x + dx * lc.xx + dy * lc.xy;
+   const int y = lc.y + dx * lc.yx + dy * lc.yy;
+   const float l_slope = (dx - 0.5f) * l_inv;
+   const float r_slope = (dx + 0.5f) * r_inv;
+   if (start < r_slope)
+    continue;
+   else if (end > l_slope)
+    break;
+
+   const int mx = x - lc.cx, my = y - lc.cy;
+   if (INBOUNDS(mx, my) && lit_by[mx + SEEX][my + SEEY] != lit_gen &&
+       (!lc.arc || in_arc(lc, x - lc.x, y - lc.y))) {
+    // Octants share their edges, so squares are only lit once per source
+    lit_by[mx + SEEX][my + SEEY] = lit_gen;
+    if (dirty[mx + SEEX][my + SEEY])
+     lm[mx + SEEX][my + SEEY] += light;
+   }
+
+   const float here = (INBOUNDS_LARGE(mx, my) ?
+                       c[mx + LIGHTMAP_RANGE_X][my + LIGHTMAP_RANGE_Y].transparency :
+                       LIGHT_TRANSPARENCY_CLEAR);
+   if (run < 0) {
+    run = here;
+   } else if (here != run) {
+    // The run before this square ends; light carries on past it
+    if (run > LIGHT_TRANSPARENCY_SOLID && j < lc.range)
+     cast_light(lc, j + 1, start, l_slope, cumulative * run);
+    start = (run > LIGHT_TRANSPARENCY_SOLID ? l_slope : new_start);
+    run = here;
+   }
+   new_start = r_slope;
+  }
+  if (run <= LIGHT_TRANSPARENCY_SOLID)
+   break;
+  cumulative *= run;
+ }
+}
+
+void light_map::next_lit_gen()
+{
+ if (++lit_gen == INT_MAX) {
+  memset(lit_by, 0, sizeof(lit_by));
+  lit_gen = 1;
+ }
+}
+
+// Times the shadowcasting engine against the ray casting it replaced, over
+// the current surroundings lit by a crowd of fires and vehicle headlights.
+// Both are run over the same scene; differ counts the on-screen squares whose
+// light level comes out different.
+void light_map::benchmark(game* g, int x, int y, const int passes,
+                          int &shadow_ms, int &ray_ms, int &differ)
+{
+ build_light_cache(g, x, y);
+ std::vector<light_op> scene;
+ const int fire_lum[3] = { 16, 60, 160 };
+ for (int i = 0; i < 60; i++)
+  scene.push_back(light_op(LOP_SOURCE, x + rng(-SEEX * 2, SEEX * 2),
+                           y + rng(-SEEY * 2, SEEY * 2), fire_lum[rng(0, 2)]));
+ for (int i = 0; i < 20; i++) { // Two headlights each
+  const int vx = x + rng(-SEEX * 2, SEEX * 2), vy = y + rng(-SEEY * 2, SEEY * 2);
+  const int dir = rng(0, 23) * 15;
+  scene.push_back(light_op(LOP_ARC, vx, vy, 120, dir));
+  scene.push_back(light_op(LOP_ARC, vx + 1, vy, 120, dir));
+ }
+ memset(dirty, true, sizeof(dirty));
+
+ lit_level shadow_lit[LIGHTMAP_X][LIGHTMAP_Y];
+ clock_t begin = clock();
+ for (int pass = 0; pass < passes; pass++) {
+  memset(lm, 0, sizeof(lm));
+  memset(sm, 0, sizeof(sm));
+  for (int i = 0; i < scene.size(); i++) {
+   if (scene[i].type == LOP_SOURCE)
+    apply_light_source(scene[i].x, scene[i].y, x, y, scene[i].luminance);
+   else
+    apply_light_arc(scene[i].x, scene[i].y, scene[i].angle, x, y, scene[i].luminance);
+  }
+ }
+ shadow_ms = int((clock() - begin) * 1000 / CLOCKS_PER_SEC);
+ for (int i = 0; i < LIGHTMAP_X; i++) {
+  for (int j = 0; j < LIGHTMAP_Y; j++)
+   shadow_lit[i][j] = at(i - SEEX, j - SEEY);
+ }
+
+ begin = clock();
+ for (int pass = 0; pass < passes; pass++) {
+  memset(lm, 0, sizeof(lm));
+  memset(sm, 0, sizeof(sm));
+  for (int i = 0; i < scene.size(); i++) {
+   if (scene[i].type == LOP_SOURCE)
+    ray_light_source(scene[i].x, scene[i].y, x, y, scene[i].luminance);
+   else
+    ray_light_arc(scene[i].x, scene[i].y, scene[i].angle, x, y, scene[i].luminance);
+  }
+ }
+ ray_ms = int((clock() - begin) * 1000 / CLOCKS_PER_SEC);
+ differ = 0;
+ for (int i = 0; i < LIGHTMAP_X; i++) {
+  for (int j = 0; j < LIGHTMAP_Y; j++) {
+   if (shadow_lit[i][j] != at(i - SEEX, j - SEEY))
+    differ++;
+  }
+ }
+
+ generated = false; // The real light map is gone; rebuild it in full
+}
+
+// The ray casting engine shadowcasting replaced, kept for benchmark()
+void light_map::ray_light_source(int x, int y, int cx, int cy, float luminance)
 {
  bool lit[LIGHTMAP_X][LIGHTMAP_Y];
  memset(lit, 0, sizeof(lit));
 
  if (INBOUNDS(x - cx, y - cy)) {
   lit[x - cx + SEEX][y - cy + SEEY] = true;
-  lm[x - cx + SEEX][y - cy + SEEY] += std::max(luminance, static_cast<float>(LL_LOW));
-  sm[x - cx + SEEX][y - cy + SEEY] += luminance;
+  if (dirty[x - cx + SEEX][y - cy + SEEY]) {
+   lm[x - cx + SEEX][y - cy + SEEY] += std::max(luminance, static_cast<float>(LL_LOW));
+   sm[x - cx + SEEX][y - cy + SEEY] += luminance;
+  }
  }
 
  if (luminance > LIGHT_SOURCE_LOCAL) {
@@ -254,7 +697,7 @@ void light_map::apply_light_source(int x, int y, int cx, int cy, float luminance
  }
 }
 
-void light_map::apply_light_arc(int x, int y, int angle, int cx, int cy, float luminance)
+void light_map::ray_light_arc(int x, int y, int angle, int cx, int cy, float luminance)
 {
  if (luminance <= LIGHT_SOURCE_LOCAL)
   return;
@@ -263,7 +706,7 @@ void light_map::apply_light_arc(int x, int y, int angle, int cx, int cy, float l
  memset(lit, 0, sizeof(lit));
 
  int range = LIGHT_RANGE(luminance);
- apply_light_source(x, y, cx, cy, LIGHT_SOURCE_LOCAL);
+ ray_light_source(x, y, cx, cy, LIGHT_SOURCE_LOCAL);
 
  // Normalise (should work with negative values too)
  angle = angle % 360;
@@ -339,7 +782,8 @@ void light_map::apply_light_ray(bool lit[LIGHTMAP_X][LIGHTMAP_Y], int sx, int sy
 
     // We know x is the longest angle here and squares can ignore the abs calculation
     float light = luminance / ((sx - x) * (sx - x));
-    lm[x - cx + SEEX][y - cy + SEEY] += light * transparency;
+    if (dirty[x - cx + SEEX][y - cy + SEEY])
+     lm[x - cx + SEEX][y - cy + SEEY] += light * transparency;
    }
 
    if (INBOUNDS_LARGE(x - cx, y - cy))
@@ -366,7 +810,8 @@ void light_map::apply_light_ray(bool lit[LIGHTMAP_X][LIGHTMAP_Y], int sx, int sy
 
     // We know y is the longest angle here and squares can ignore the abs calculation
     float light = luminance / ((sy - y) * (sy - y));
-    lm[x - cx + SEEX][y - cy + SEEY] += light;
+    if (dirty[x - cx + SEEX][y - cy + SEEY])
+     lm[x - cx + SEEX][y - cy + SEEY] += light;
    }
 
    if (INBOUNDS_LARGE(x - cx, y - cy))
@@ -401,6 +846,7 @@ void light_map::build_outside_cache(map *m, const int x, const int y, const int
 void light_map::build_light_cache(game* g, int cx, int cy)
 {
  // Clear cache
+ veh_lights.clear();
  // Initialize cache of outside tiles
  memset(outside_cache, true, sizeof(outside_cache));
  for(int sx = cx - LIGHTMAP_RANGE_X; sx <= cx + LIGHTMAP_RANGE_X; ++sx) {
@@ -413,15 +859,9 @@ void light_map::build_light_cache(game* g, int cx, int cy)
    c[x][y].veh = NULL;
    c[x][y].veh_part = 0;
    c[x][y].veh_light = 0;
-   c[x][y].mon = -1;
   }
  }
 
- // Check for critters and cache
- for (int i = 0; i < g->z.size(); ++i)
-  if (INBOUNDS(g->z[i].posx - cx, g->z[i].posy - cy))
-   c[g->z[i].posx - cx + LIGHTMAP_RANGE_X][g->z[i].posy - cy + LIGHTMAP_RANGE_Y].mon = i;
-
  // Check for vehicles and cache
  VehicleList vehs = g->m.get_vehicles(cx - LIGHTMAP_RANGE_X, cy - LIGHTMAP_RANGE_Y, cx + LIGHTMAP_RANGE_X, cy + LIGHTMAP_RANGE_Y);
  for(int v = 0; v < vehs.size(); ++v) {
@@ -443,8 +883,11 @@ void light_map::build_light_cache(game* g, int cx, int cy)
 
     if (vehs[v].item->lights_on &&
         vehs[v].item->part_flag(p, vpf_light) &&
-        vehs[v].item->parts[p].hp > 0)
+        vehs[v].item->parts[p].hp > 0) {
+     if (!c[px][py].veh_light)
+      veh_lights.push_back(point(px, py));
      c[px][py].veh_light = vehs[v].item->part_info(p).power;
+    }
    }
   }
  }
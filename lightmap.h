@@ -3,6 +3,7 @@
 
 #include "mapdata.h"
 #include "map.h"
+#include <vector>
 
 #define LIGHT_SOURCE_LOCAL  0.1
 #define LIGHT_SOURCE_BRIGHT 10
@@ -32,12 +33,39 @@ enum lit_level {
  LL_BRIGHT  // Probably only for light sources
 };
 
+// One step of building the light map, in the order generate() applies them.
+// Kept between frames so a redraw can tell which light changed and redo only
+// the squares it reaches.
+enum light_op_type {
+ LOP_AMBIENT, // Set a square to natural light (indoor/outdoor divide)
+ LOP_SOURCE,  // apply_light_source()
+ LOP_ARC      // apply_light_arc()
+};
+
+struct light_op {
+ light_op_type type;
+ int x, y;  // Map coordinates
+ int angle; // LOP_ARC only
+ float luminance;
+
+ light_op(light_op_type t, int px, int py, float lum, int ang = 0)
+  : type(t), x(px), y(py), angle(ang), luminance(lum) {}
+
+ int range() const;
+ bool operator==(const light_op &b) const;
+ bool operator<(const light_op &b) const;
+};
+
+struct light_map_stats {
+ int full, partial, skipped; // Kinds of generate() call
+ light_map_stats() : full(0), partial(0), skipped(0) {}
+};
+
 struct light_map_cache {
  float transparency;
  vehicle* veh;
  int veh_part;
  int veh_light;
- int mon;
 };
 
 class light_map
@@ -45,6 +73,17 @@ class light_map
  public:
   light_map();
 
+  // One octant of a light being shadowcast; see cast_light()
+  struct light_cast {
+   int x, y;   // Source
+   int cx, cy; // Light map center
+   int range;
+   int xx, xy, yx, yy; // Octant transform
+   float luminance;
+   bool arc;   // Whether the edge of an arc cuts this octant
+   float arc_x, arc_y; // Heading of the arc
+  };
+
   void generate(game* g, int x, int y, float natural_light, float luminance);
   
   lit_level at(int dx, int dy); // Assumes 0,0 is light map center
@@ -53,16 +92,43 @@ class light_map
   bool is_outside(int dx, int dy);
   bool sees(int fx, int fy, int tx, int ty, int max_range);
 
+  light_map_stats stats;
+
+  void benchmark(game* g, int x, int y, const int passes,
+                 int &shadow_ms, int &ray_ms, int &differ);
+
  private:
   typedef light_map_cache light_cache[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y];
   float lm[LIGHTMAP_X][LIGHTMAP_Y];
   float sm[LIGHTMAP_X][LIGHTMAP_Y];
   bool outside_cache[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y];
   light_cache c;
+  std::vector<point> veh_lights; // Cache squares with a vehicle light on
+
+  // State of the last generate(), which later ones update in place
+  bool generated;
+  int gen_x, gen_y;
+  float gen_natural_light;
+  std::vector<light_op> ops;
+  bool dirty[LIGHTMAP_X][LIGHTMAP_Y]; // Squares being recomputed
+  float prev_transparency[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y];
+  bool prev_outside[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y];
+
+  void build_ops(game* g, int x, int y, float natural_light, float luminance);
+  bool mark_dirty(const std::vector<light_op> &old_ops, int cx, int cy);
+  void mark_dirty_box(const light_op &op, int cx, int cy);
+
+  int lit_by[LIGHTMAP_X][LIGHTMAP_Y]; // lit_gen of the last source to light each square
+  int lit_gen;
 
   void apply_light_source(int x, int y, int cx, int cy, float luminance);
   void apply_light_arc(int x, int y, int angle, int cx, int cy, float luminance);
+  void cast_light(const light_cast &lc, const int row, float start,
+                  const float end, float cumulative);
+  void next_lit_gen();
 
+  void ray_light_source(int x, int y, int cx, int cy, float luminance);
+  void ray_light_arc(int x, int y, int angle, int cx, int cy, float luminance);
   void apply_light_ray(bool lit[LIGHTMAP_X][LIGHTMAP_Y], int sx, int sy,
                        int ex, int ey, int cx, int cy, float luminance);
 
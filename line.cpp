@@ -6,8 +6,16 @@
 std::vector <point> line_to(int x1, int y1, int x2, int y2, int t)
 {
  std::vector<point> ret;
+ line_to(x1, y1, x2, y2, t, ret);
+ return ret;
+}
+
+void line_to(int x1, int y1, int x2, int y2, int t, std::vector<point> &ret)
+{
+ ret.clear();
  int dx = x2 - x1;
  int dy = y2 - y1;
+ ret.reserve(abs(dx) > abs(dy) ? abs(dx) : abs(dy));
  int ax = abs(dx)<<1;
  int ay = abs(dy)<<1;
  int sx = SGN(dx);
@@ -56,7 +64,6 @@ std::vector <point> line_to(int x1, int y1, int x2, int y2, int t)
   } while ((cur.x != x2 || cur.y != y2) &&
            (cur.x >= xmin && cur.x <= xmax && cur.y >= ymin && cur.y <= ymax));
  }
- return ret;
 }
 
 int trig_dist(int x1, int y1, int x2, int y2)
@@ -20,6 +20,8 @@ NORTHWEST
 
 // The "t" value decides WHICH Bresenham line is used.
 std::vector <point> line_to(int x1, int y1, int x2, int y2, int t);
+// The same, filled into ret in place so that its storage gets reused
+void line_to(int x1, int y1, int x2, int y2, int t, std::vector<point> &ret);
 // sqrt(dX^2 + dY^2)
 int trig_dist(int x1, int y1, int x2, int y2);
 // Roguelike distance; minimum of dX and dY
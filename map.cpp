@@ -9,6 +9,8 @@
 #include <cmath>
 #include <stdlib.h>
 #include <fstream>
+#include <bitset>
+#include <ctime>
 #include "debug.h"
 
 #include "debug.h"
@@ -34,6 +36,10 @@ map::map()
   my_MAPSIZE = MAPSIZE;
  dbg(D_INFO) << "map::map(): my_MAPSIZE: " << my_MAPSIZE;
  veh_in_active_range = true;
+ terrain_version = 0;
+ target_fovs_used = 0;
+ field_job_count = 0;
+ field_turn = 0;
 }
 
 map::map(std::vector<itype*> *itptr, std::vector<itype_id> (*miptr)[num_itloc],
@@ -53,6 +59,10 @@ map::map(std::vector<itype*> *itptr, std::vector<itype_id> (*miptr)[num_itloc],
  dbg(D_INFO) << "map::map( itptr["<<itptr<<"], miptr["<<miptr<<"], trptr["<<trptr<<"] ): my_MAPSIZE: " << my_MAPSIZE;
  veh_in_active_range = true;
  memset(veh_exists_at, 0, sizeof(veh_exists_at));
+ terrain_version = 0;
+ target_fovs_used = 0;
+ field_job_count = 0;
+ field_turn = 0;
 }
 
 map::~map()
@@ -670,7 +680,10 @@ bool map::displace_water (const int x, const int y)
 ter_id& map::ter(const int x, const int y)
 {
  if (!INBOUNDS(x, y)) {
-  nulter = t_null;
+// Only written when someone wrote through it, so that the field passes can
+// look off the edge of the map from several threads at once
+  if (nulter != t_null)
+   nulter = t_null;
   return nulter;	// Out-of-bounds - null terrain 
  }
 /*
@@ -684,6 +697,17 @@ ter_id& map::ter(const int x, const int y)
  return grid[nonant]->ter[lx][ly];
 }
 
+// Terrain changes during play go through here, so that cached routes and
+// fields of view see them; see terrain_version
+void map::ter_set(const int x, const int y, const ter_id new_terrain)
+{
+ ter_id &t = ter(x, y);
+ if (t == new_terrain || !INBOUNDS(x, y))
+  return;
+ t = new_terrain;
+ terrain_version++;
+}
+
 std::string map::tername(const int x, const int y)
 {
  return terlist[ter(x, y)].name;
@@ -909,7 +933,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result && str >= rng(0, 50)) {
    sound += "clang!";
-   ter(x, y) = t_chainfence_posts;
+   ter_set(x, y, t_chainfence_posts);
    add_item(x, y, (*itypes)[itm_wire], 0, rng(4, 10));
    return true;
   } else {
@@ -923,7 +947,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result && str >= rng(0, 120)) {
    sound += "crunch!";
-   ter(x, y) = t_wall_wood_chipped;
+   ter_set(x, y, t_wall_wood_chipped);
    if(one_in(2))
     add_item(x, y, (*itypes)[itm_2x4], 0);
    add_item(x, y, (*itypes)[itm_nail], 0, 2);
@@ -940,7 +964,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result && str >= rng(0, 100)) {
    sound += "crunch!";
-   ter(x, y) = t_wall_wood_broken;
+   ter_set(x, y, t_wall_wood_broken);
    add_item(x, y, (*itypes)[itm_2x4], 0, rng(1, 4));
    add_item(x, y, (*itypes)[itm_nail], 0, rng(1, 3));
    add_item(x, y, (*itypes)[itm_splinter], 0);
@@ -956,7 +980,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result && str >= rng(0, 80)) {
    sound += "crash!";
-   ter(x, y) = t_dirt;
+   ter_set(x, y, t_dirt);
    add_item(x, y, (*itypes)[itm_2x4], 0, rng(2, 5));
    add_item(x, y, (*itypes)[itm_nail], 0, rng(4, 10));
    add_item(x, y, (*itypes)[itm_splinter], 0);
@@ -972,7 +996,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result && str >= rng(0, 80)) {
    sound += "clang!";
-   ter(x, y) = t_dirt;
+   ter_set(x, y, t_dirt);
    add_item(x, y, (*itypes)[itm_wire], 0, rng(8, 20));
    add_item(x, y, (*itypes)[itm_scrap], 0, rng(0, 12));
    return true;
@@ -989,7 +1013,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "smash!";
-   ter(x, y) = t_door_b;
+   ter_set(x, y, t_door_b);
    return true;
   } else {
    sound += "whump!";
@@ -1002,7 +1026,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "crash!";
-   ter(x, y) = t_door_frame;
+   ter_set(x, y, t_door_frame);
    add_item(x, y, (*itypes)[itm_2x4], 0, rng(1, 6));
    add_item(x, y, (*itypes)[itm_nail], 0, rng(2, 12));
    add_item(x, y, (*itypes)[itm_splinter], 0);
@@ -1019,7 +1043,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "glass breaking!";
-   ter(x, y) = t_window_frame;
+   ter_set(x, y, t_window_frame);
   add_item(x, y, (*itypes)[itm_curtain], 0);
   add_item(x, y, (*itypes)[itm_curtain], 0);
   add_item(x, y, (*itypes)[itm_stick], 0);
@@ -1036,7 +1060,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "glass breaking!";
-   ter(x, y) = t_window_frame;
+   ter_set(x, y, t_window_frame);
    return true;
   } else {
    sound += "whack!";
@@ -1049,7 +1073,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "crash!";
-   ter(x, y) = t_door_frame;
+   ter_set(x, y, t_door_frame);
    add_item(x, y, (*itypes)[itm_2x4], 0, rng(1, 6));
    add_item(x, y, (*itypes)[itm_nail], 0, rng(2, 12));
    add_item(x, y, (*itypes)[itm_splinter], 0);
@@ -1065,7 +1089,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "crash!";
-   ter(x, y) = t_window_frame;
+   ter_set(x, y, t_window_frame);
    const int num_boards = rng(0, 2) * rng(0, 1);
    for (int i = 0; i < num_boards; i++)
     add_item(x, y, (*itypes)[itm_splinter], 0);
@@ -1102,7 +1126,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
     for (int j = -1; j <= 1; j++) {
      if (ter(tentx + i, tenty + j) == t_groundsheet)
       add_item(tentx + i, tenty + j, (*itypes)[itm_broketent], 0);
-     ter(tentx + i, tenty + j) = t_dirt;
+     ter_set(tentx + i, tenty + j, t_dirt);
     }
 
    sound += "rrrrip!";
@@ -1118,7 +1142,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "rrrrip!";
-   ter(x, y) = t_dirt;
+   ter_set(x, y, t_dirt);
    return true;
   } else {
    sound += "slap!";
@@ -1133,7 +1157,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "metal screeching!";
-   ter(x, y) = t_metal;
+   ter_set(x, y, t_metal);
    add_item(x, y, (*itypes)[itm_scrap], 0, rng(2, 8));
    const int num_boards = rng(0, 3);
    for (int i = 0; i < num_boards; i++)
@@ -1151,7 +1175,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "porcelain breaking!";
-   ter(x, y) = t_rubble;
+   ter_set(x, y, t_rubble);
    return true;
   } else {
    sound += "whunk!";
@@ -1165,7 +1189,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "smash!";
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
    add_item(x, y, (*itypes)[itm_2x4], 0, rng(2, 6));
    add_item(x, y, (*itypes)[itm_nail], 0, rng(4, 12));
    add_item(x, y, (*itypes)[itm_splinter], 0);
@@ -1181,7 +1205,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "crak";
-   ter(x, y) = t_dirt;
+   ter_set(x, y, t_dirt);
    add_item(x, y, (*itypes)[itm_spear_wood], 0, 2);
    return true;
   } else {
@@ -1196,7 +1220,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "smash!";
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
    add_item(x, y, (*itypes)[itm_2x4], 0, rng(1, 3));
    add_item(x, y, (*itypes)[itm_nail], 0, rng(2, 6));
    add_item(x, y, (*itypes)[itm_splinter], 0);
@@ -1216,7 +1240,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "glass breaking!";
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
    return true;
   } else {
    sound += "whack!";
@@ -1230,7 +1254,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "glass breaking!";
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
    return true;
   } else {
    sound += "whack!";
@@ -1243,7 +1267,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "crunch!";
-   ter(x, y) = t_underbrush;
+   ter_set(x, y, t_underbrush);
    const int num_sticks = rng(0, 3);
    for (int i = 0; i < num_sticks; i++)
     add_item(x, y, (*itypes)[itm_stick], 0);
@@ -1259,7 +1283,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result && !one_in(4)) {
    sound += "crunch.";
-   ter(x, y) = t_dirt;
+   ter_set(x, y, t_dirt);
    return true;
   } else {
    sound += "brush.";
@@ -1270,7 +1294,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
  case t_shrub:
   if (str >= rng(0, 30) && str >= rng(0, 30) && str >= rng(0, 30) && one_in(2)){
    sound += "crunch.";
-   ter(x, y) = t_underbrush;
+   ter_set(x, y, t_underbrush);
    return true;
   } else {
    sound += "brush.";
@@ -1283,7 +1307,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "crunch!";
-   ter(x, y) = t_fungus;
+   ter_set(x, y, t_fungus);
    return true;
   } else {
    sound += "whack!";
@@ -1296,7 +1320,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "ker-rash!";
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
    return true;
   } else {
    sound += "plunk.";
@@ -1308,7 +1332,7 @@ bool map::bash(const int x, const int y, const int str, std::string &sound, int
   if (res) *res = result;
   if (str >= result) {
    sound += "smash";
-   ter(x, y) = t_dirt;
+   ter_set(x, y, t_dirt);
    add_item(x, y, (*itypes)[itm_2x4], 0, rng(1, 5));
    add_item(x, y, (*itypes)[itm_nail], 0, rng(2, 10));
    return true;
@@ -1343,14 +1367,14 @@ void map::destroy(game *g, const int x, const int y, const bool makesound)
     }
    }
   }
-  ter(x, y) = t_rubble;
+  ter_set(x, y, t_rubble);
   break;
 
  case t_door_c:
  case t_door_b:
  case t_door_locked:
  case t_door_boarded:
-  ter(x, y) = t_door_frame;
+  ter_set(x, y, t_door_frame);
   for (int i = x - 2; i <= x + 2; i++) {
    for (int j = y - 2; j <= y + 2; j++) {
     if (move_cost(i, j) > 0 && one_in(6))
@@ -1368,7 +1392,7 @@ void map::destroy(game *g, const int x, const int y, const bool makesound)
    for (int j = y - 2; j <= y + 2; j++) {
     if (move_cost(i, j) > 0 && one_in(5))
      add_item(i, j, g->itypes[itm_rock], 0);
-    ter(x, y) = t_rubble;
+    ter_set(x, y, t_rubble);
    }
   }
   break;
@@ -1389,7 +1413,7 @@ void map::destroy(game *g, const int x, const int y, const bool makesound)
       add_item(i, j, g->itypes[itm_nail], 0, 3);
    }
   }
-  ter(x, y) = t_rubble;
+  ter_set(x, y, t_rubble);
   for (int i = x - 1; i <= x + 1; i++)
    for (int j = y - 1; j <= y + 1; j++) {
      if (i == x && j == y || !has_flag(collapses, i, j))
@@ -1426,7 +1450,7 @@ void map::destroy(game *g, const int x, const int y, const bool makesound)
       add_item(i, j, g->itypes[itm_nail], 0, 3);
    }
   }
-  ter(x, y) = t_rubble;
+  ter_set(x, y, t_rubble);
   for (int i = x - 1; i <= x + 1; i++)
    for (int j = y - 1; j <= y + 1; j++) {
      if (i == x && j == y || !has_flag(supports_roof, i, j))
@@ -1453,7 +1477,7 @@ void map::destroy(game *g, const int x, const int y, const bool makesound)
  default:
   if (makesound && has_flag(explodes, x, y) && one_in(2))
    g->explosion(x, y, 40, 0, true);
-  ter(x, y) = t_rubble;
+  ter_set(x, y, t_rubble);
  }
 
  if (makesound)
@@ -1485,7 +1509,7 @@ void map::shoot(game *g, const int x, const int y, int &dam,
   if (hit_items || one_in(8)) {	// 1 in 8 chance of hitting the door
    dam -= rng(20, 40);
    if (dam > 0)
-    ter(x, y) = t_dirt;
+    ter_set(x, y, t_dirt);
   } else
    dam -= rng(0, 1);
   break;
@@ -1496,25 +1520,25 @@ void map::shoot(game *g, const int x, const int y, int &dam,
  case t_door_locked_alarm:
   dam -= rng(15, 30);
   if (dam > 0)
-   ter(x, y) = t_door_b;
+   ter_set(x, y, t_door_b);
   break;
 
  case t_door_boarded:
   dam -= rng(15, 35);
   if (dam > 0)
-   ter(x, y) = t_door_b;
+   ter_set(x, y, t_door_b);
   break;
 
  case t_window:
  case t_window_alarm:
   dam -= rng(0, 5);
-  ter(x, y) = t_window_frame;
+  ter_set(x, y, t_window_frame);
   break;
 
  case t_window_boarded:
   dam -= rng(10, 30);
   if (dam > 0)
-   ter(x, y) = t_window_frame;
+   ter_set(x, y, t_window_frame);
   break;
 
  case t_wall_glass_h:
@@ -1522,13 +1546,13 @@ void map::shoot(game *g, const int x, const int y, int &dam,
  case t_wall_glass_h_alarm:
  case t_wall_glass_v_alarm:
   dam -= rng(0, 8);
-  ter(x, y) = t_floor;
+  ter_set(x, y, t_floor);
   break;
 
  case t_paper:
   dam -= rng(4, 16);
   if (dam > 0)
-   ter(x, y) = t_dirt;
+   ter_set(x, y, t_dirt);
   if (effects & mfb(AMMO_INCENDIARY))
    add_field(g, x, y, fd_fire, 1);
   break;
@@ -1546,7 +1570,7 @@ void map::shoot(game *g, const int x, const int y, int &dam,
       }
      }
     }
-    ter(x, y) = t_gas_pump_smashed;
+    ter_set(x, y, t_gas_pump_smashed);
    }
    dam -= 60;
   }
@@ -1555,7 +1579,7 @@ void map::shoot(game *g, const int x, const int y, int &dam,
  case t_vat:
   if (dam >= 10) {
    g->sound(x, y, 15, "ke-rash!");
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
   } else
    dam = 0;
   break;
@@ -1636,30 +1660,30 @@ bool map::hit_with_acid(game *g, const int x, const int y)
   case t_wall_glass_v_alarm:
   case t_wall_glass_h_alarm:
   case t_vat:
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
    break;
 
   case t_door_c:
   case t_door_locked:
   case t_door_locked_alarm:
    if (one_in(3))
-    ter(x, y) = t_door_b;
+    ter_set(x, y, t_door_b);
    break;
 
   case t_door_b:
    if (one_in(4))
-    ter(x, y) = t_door_frame;
+    ter_set(x, y, t_door_frame);
    else
     return false;
    break;
 
   case t_window:
   case t_window_alarm:
-   ter(x, y) = t_window_empty;
+   ter_set(x, y, t_window_empty);
    break;
 
   case t_wax:
-   ter(x, y) = t_floor_wax;
+   ter_set(x, y, t_floor_wax);
    break;
 
   case t_toilet:
@@ -1669,7 +1693,7 @@ bool map::hit_with_acid(game *g, const int x, const int y)
 
   case t_card_science:
   case t_card_military:
-   ter(x, y) = t_card_reader_broken;
+   ter_set(x, y, t_card_reader_broken);
    break;
  }
 
@@ -1683,40 +1707,40 @@ void map::marlossify(const int x, const int y)
   case 1:
   case 2:
   case 3:
-  case 4: ter(x, y) = t_fungus;      break;
+  case 4: ter_set(x, y, t_fungus);      break;
   case 5:
   case 6:
-  case 7: ter(x, y) = t_marloss;     break;
-  case 8: ter(x, y) = t_tree_fungal; break;
-  case 9: ter(x, y) = t_slime;       break;
+  case 7: ter_set(x, y, t_marloss);     break;
+  case 8: ter_set(x, y, t_tree_fungal); break;
+  case 9: ter_set(x, y, t_slime);       break;
  }
 }
 
 bool map::open_door(const int x, const int y, const bool inside)
 {
  if (ter(x, y) == t_door_c) {
-  ter(x, y) = t_door_o;
+  ter_set(x, y, t_door_o);
   return true;
  } else if (ter(x, y) == t_canvas_door) {
-  ter(x, y) = t_canvas_door_o;
+  ter_set(x, y, t_canvas_door_o);
  } else if (inside && ter(x, y) == t_curtains) {
-  ter(x, y) = t_window_domestic;
+  ter_set(x, y, t_window_domestic);
   return true;
  } else if (inside && ter(x, y) == t_window_domestic) {
-  ter(x, y) = t_window_open;
+  ter_set(x, y, t_window_open);
   return true;
  } else if (ter(x, y) == t_chaingate_c) {
-  ter(x, y) = t_chaingate_o;
+  ter_set(x, y, t_chaingate_o);
   return true;
  } else if (ter(x, y) == t_door_metal_c) {
-  ter(x, y) = t_door_metal_o;
+  ter_set(x, y, t_door_metal_o);
   return true;
  } else if (ter(x, y) == t_door_glass_c) {
-  ter(x, y) = t_door_glass_o;
+  ter_set(x, y, t_door_glass_o);
   return true;
  } else if (inside &&
             (ter(x, y) == t_door_locked || ter(x, y) == t_door_locked_alarm)) {
-  ter(x, y) = t_door_o;
+  ter_set(x, y, t_door_o);
   return true;
  }
  return false;
@@ -1732,7 +1756,7 @@ void map::translate(const ter_id from, const ter_id to)
  for (int x = 0; x < SEEX * my_MAPSIZE; x++) {
   for (int y = 0; y < SEEY * my_MAPSIZE; y++) {
    if (ter(x, y) == from)
-    ter(x, y) = to;
+    ter_set(x, y, to);
   }
  }
 }
@@ -1740,24 +1764,24 @@ void map::translate(const ter_id from, const ter_id to)
 bool map::close_door(const int x, const int y, const bool inside)
 {
  if (ter(x, y) == t_door_o) {
-  ter(x, y) = t_door_c;
+  ter_set(x, y, t_door_c);
   return true;
  } else if (inside && ter(x, y) == t_window_domestic) {
-  ter(x, y) = t_curtains;
+  ter_set(x, y, t_curtains);
   return true;
  } else if (ter(x, y) == t_canvas_door_o) {
-  ter(x, y) = t_canvas_door;
+  ter_set(x, y, t_canvas_door);
  } else if (inside && ter(x, y) == t_window_open) {
-  ter(x, y) = t_window_domestic;
+  ter_set(x, y, t_window_domestic);
   return true;
  } else if (ter(x, y) == t_chaingate_o) {
-  ter(x, y) = t_chaingate_c;
+  ter_set(x, y, t_chaingate_c);
   return true;
  } else if (ter(x, y) == t_door_metal_o) {
-  ter(x, y) = t_door_metal_c;
+  ter_set(x, y, t_door_metal_c);
   return true;
  } else if (ter(x, y) == t_door_glass_o) {
-  ter(x, y) = t_door_glass_c;
+  ter_set(x, y, t_door_glass_c);
   return true;
  }
  return false;
@@ -1780,6 +1804,35 @@ int& map::radiation(const int x, const int y)
  return grid[nonant]->rad[lx][ly];
 }
 
+map_region map::region(const int x1, const int y1, const int x2, const int y2)
+{
+ map_region ret;
+ const int minx = std::max(x1, 0), maxx = std::min(x2, SEEX * my_MAPSIZE - 1);
+ const int miny = std::max(y1, 0), maxy = std::min(y2, SEEY * my_MAPSIZE - 1);
+ if (minx > maxx || miny > maxy)
+  return ret;
+ for (int gx = minx / SEEX; gx <= maxx / SEEX; gx++) {
+  for (int gy = miny / SEEY; gy <= maxy / SEEY; gy++) {
+   submap_span span;
+   span.sm = grid[gx + gy * my_MAPSIZE];
+   span.x = gx * SEEX;
+   span.y = gy * SEEY;
+   span.lx1 = std::max(minx - span.x, 0);
+   span.ly1 = std::max(miny - span.y, 0);
+   span.lx2 = std::min(maxx - span.x, SEEX - 1);
+   span.ly2 = std::min(maxy - span.y, SEEY - 1);
+   ret.push_back(span);
+  }
+ }
+ return ret;
+}
+
+map_region map::region(const point center, const int radius)
+{
+ return region(center.x - radius, center.y - radius,
+               center.x + radius, center.y + radius);
+}
+
 std::vector<item>& map::i_at(const int x, const int y)
 {
  if (!INBOUNDS(x, y)) {
@@ -1900,46 +1953,160 @@ void map::add_item(const int x, const int y, item new_item)
  const int ly = y % SEEY;
  grid[nonant]->itm[lx][ly].push_back(new_item);
  if (new_item.active)
-  grid[nonant]->active_item_count++;
+  add_active_item(x, y);
+ if (light_emitter_at(grid[nonant], lx, ly))
+  add_light_emitter(x, y);
 }
 
 void map::process_active_items(game *g)
 {
  for (int gx = 0; gx < my_MAPSIZE; gx++) {
   for (int gy = 0; gy < my_MAPSIZE; gy++) {
-   if (grid[gx + gy * my_MAPSIZE]->active_item_count > 0)
+   if (!grid[gx + gy * my_MAPSIZE]->active_items.empty())
     process_active_items_in_submap(g, gx + gy * my_MAPSIZE);
   }
  }
 }
-     
+
+// Goes through the squares listed as holding active items, dropping those
+// that turn out to have none left.  Using an item may add squares to the list
+// (a grenade going off can scatter more), so it's walked by index.
 void map::process_active_items_in_submap(game *g, const int nonant)
 {
  it_tool* tmp;
  iuse use;
- for (int i = 0; i < SEEX; i++) {
-  for (int j = 0; j < SEEY; j++) {
-   std::vector<item> *items = &(grid[nonant]->itm[i][j]);
-   for (int n = 0; n < items->size(); n++) {
-    if ((*items)[n].active) {
-     if (!(*items)[n].is_tool()) { // It's probably a charger gun
-      (*items)[n].active = false;
-      (*items)[n].charges = 0;
-     } else { 
-      tmp = dynamic_cast<it_tool*>((*items)[n].type);
-      (use.*tmp->use)(g, &(g->u), &((*items)[n]), true);
-      if (tmp->turns_per_charge > 0 && int(g->turn) % tmp->turns_per_charge ==0)
-       (*items)[n].charges--;
-      if ((*items)[n].charges <= 0) {
-       (use.*tmp->use)(g, &(g->u), &((*items)[n]), false);
-       if (tmp->revert_to == itm_null || (*items)[n].charges == -1) {
-        items->erase(items->begin() + n);
-        grid[nonant]->active_item_count--;
-        n--;
-       } else
-        (*items)[n].type = g->itypes[tmp->revert_to];
-      }
+ std::vector<point> &squares = grid[nonant]->active_items;
+ for (int s = 0; s < squares.size(); s++) {
+  const int i = squares[s].x, j = squares[s].y;
+  std::vector<item> *items = &(grid[nonant]->itm[i][j]);
+  bool still_active = false;
+  for (int n = 0; n < items->size(); n++) {
+   if ((*items)[n].active) {
+    if (!(*items)[n].is_tool()) { // It's probably a charger gun
+     (*items)[n].active = false;
+     (*items)[n].charges = 0;
+    } else { 
+     tmp = static_cast<it_tool*>((*items)[n].type);
+     (use.*tmp->use)(g, &(g->u), &((*items)[n]), true);
+     if (tmp->turns_per_charge > 0 && int(g->turn) % tmp->turns_per_charge ==0)
+      (*items)[n].charges--;
+     if ((*items)[n].charges <= 0) {
+      (use.*tmp->use)(g, &(g->u), &((*items)[n]), false);
+      if (tmp->revert_to == itm_null || (*items)[n].charges == -1) {
+       items->erase(items->begin() + n);
+       n--;
+       continue;
+      } else
+       (*items)[n].type = g->itypes[tmp->revert_to];
      }
+     if ((*items)[n].active)
+      still_active = true;
+    }
+   }
+  }
+  if (!still_active) {
+   squares.erase(squares.begin() + s);
+   s--;
+  }
+ }
+}
+
+void map::add_active_item(const int x, const int y)
+{
+ if (!INBOUNDS(x, y))
+  return;
+ std::vector<point> &squares = grid[int(x / SEEX) + int(y / SEEY) * my_MAPSIZE]->active_items;
+ const point p(x % SEEX, y % SEEY);
+ for (int i = 0; i < squares.size(); i++) {
+  if (squares[i].x == p.x && squares[i].y == p.y)
+   return;
+ }
+ squares.push_back(p);
+}
+
+// Brings a submap that's been outside the reality bubble up to the present
+// turn, working out what the turns it missed would have done in one step
+// rather than going through them.  Food needs nothing, as how rotten it is
+// comes from its birthday.
+void map::catch_up(game *g, submap *sm)
+{
+ const int now = int(g->turn), then = sm->turn_last_touched;
+ const int turns = now - then;
+ if (turns <= 0)
+  return;
+ sm->turn_last_touched = now;
+
+// Radiation slowly decays, a point for every hundredth turn that went by
+ const int decay = now / 100 - then / 100;
+ for (int lx = 0; lx < SEEX && decay > 0; lx++) {
+  for (int ly = 0; ly < SEEY; ly++)
+   sm->rad[lx][ly] = (sm->rad[lx][ly] > decay ? sm->rad[lx][ly] - decay : 0);
+ }
+
+// Fields thin out by one step per half-life, and don't spread
+ for (int lx = 0; lx < SEEX; lx++) {
+  for (int ly = 0; ly < SEEY; ly++) {
+   field &fd = sm->fld[lx][ly];
+   const int halflife = fieldlist[fd.type].halflife;
+   if (fd.type == fd_null || halflife <= 0)
+    continue;
+   const int age = fd.age + turns;
+   if (age < halflife) {
+    fd.age = age;
+    continue;
+   }
+   fd.density -= age / halflife;
+   fd.age = age % halflife;
+   if (fd.density <= 0) {
+    sm->field_count--;
+    sm->live_fields[lx] &= ~(1 << ly);
+    fd = field();
+   }
+  }
+ }
+
+// Active items run down their charges; those that would have run out are
+// switched off or gone, without whatever they'd have done on the way out
+ for (int lx = 0; lx < SEEX; lx++) {
+  for (int ly = 0; ly < SEEY; ly++) {
+   std::vector<item> &items = sm->itm[lx][ly];
+   for (int n = 0; n < items.size(); n++) {
+    item &it = items[n];
+    if (!it.active)
+     continue;
+    if (!it.is_tool()) { // It's probably a charger gun
+     it.active = false;
+     it.charges = 0;
+     continue;
+    }
+    const it_tool *tool = static_cast<it_tool*>(it.type);
+    if (tool->turns_per_charge <= 0)
+     continue;
+    it.charges -= now / tool->turns_per_charge - then / tool->turns_per_charge;
+    if (it.charges > 0)
+     continue;
+    if (tool->revert_to == itm_null) {
+     items.erase(items.begin() + n);
+     n--;
+    } else {
+     it.type = g->itypes[tool->revert_to];
+     it.active = false;
+     it.charges = 0;
+    }
+   }
+  }
+ }
+}
+
+void map::find_active_items(submap *sm)
+{
+ sm->active_items.clear();
+ for (int lx = 0; lx < SEEX; lx++) {
+  for (int ly = 0; ly < SEEY; ly++) {
+   for (int n = 0; n < sm->itm[lx][ly].size(); n++) {
+    if (sm->itm[lx][ly][n].active) {
+     sm->active_items.push_back(point(lx, ly));
+     break;
     }
    }
   }
@@ -1951,11 +2118,16 @@ void map::use_amount(const point origin, const int range, const itype_id type, c
 {
  int quantity = amount;
  for (int radius = 0; radius <= range && quantity > 0; radius++) {
-  for (int x = origin.x - radius; x <= origin.x + radius; x++) {
-   for (int y = origin.y - radius; y <= origin.y + radius; y++) {
-    if (rl_dist(origin.x, origin.y, x, y) >= radius) {
-     for (int n = 0; n < i_at(x, y).size() && quantity > 0; n++) {
-      item* curit = &(i_at(x, y)[n]);
+  map_region reg = region(origin, radius);
+  for (int s = 0; s < reg.size() && quantity > 0; s++) {
+   for (int lx = reg[s].lx1; lx <= reg[s].lx2; lx++) {
+    std::vector<item> *itm = reg[s].sm->itm[lx];
+    for (int ly = reg[s].ly1; ly <= reg[s].ly2; ly++) {
+     if (rl_dist(origin.x, origin.y, reg[s].x + lx, reg[s].y + ly) < radius)
+      continue; // Already done on an earlier pass
+     std::vector<item> &items = itm[ly];
+     for (int n = 0; n < items.size() && quantity > 0; n++) {
+      item* curit = &(items[n]);
       bool used_contents = false;
       for (int m = 0; m < curit->contents.size() && quantity > 0; m++) {
        if (curit->contents[m].type->id == type) {
@@ -1966,11 +2138,11 @@ void map::use_amount(const point origin, const int range, const itype_id type, c
        }
       }
       if (use_container && used_contents) {
-       i_rem(x, y, n);
+       items.erase(items.begin() + n);
        n--;
       } else if (curit->type->id == type && quantity > 0) {
        quantity--;
-       i_rem(x, y, n);
+       items.erase(items.begin() + n);
        n--;
       }
      }
@@ -2054,6 +2226,19 @@ trap_id& map::tr_at(const int x, const int y)
  return grid[nonant]->trp[lx][ly];
 }
 
+// Unlike tr_at(), never writes nultrap, so it's safe in the field passes
+bool map::brazier_at(const int x, const int y)
+{
+ if (!INBOUNDS(x, y))
+  return false;
+ const int nonant = int(x / SEEX) + int(y / SEEY) * my_MAPSIZE;
+ const int lx = x % SEEX;
+ const int ly = y % SEEY;
+ return (terlist[grid[nonant]->ter[lx][ly]].trap == tr_brazier ||
+         (terlist[grid[nonant]->ter[lx][ly]].trap == tr_null &&
+          grid[nonant]->trp[lx][ly] == tr_brazier));
+}
+
 void map::add_trap(const int x, const int y, const trap_id t)
 {
  if (!INBOUNDS(x, y))
@@ -2143,9 +2328,13 @@ bool map::add_field(game *g, const int x, const int y,
 
  const int lx = x % SEEX;
  const int ly = y % SEEY;
- if (grid[nonant]->fld[lx][ly].type == fd_null)
+ if (grid[nonant]->fld[lx][ly].type == fd_null) {
   grid[nonant]->field_count++;
+  grid[nonant]->live_fields[lx] |= 1 << ly;
+ }
  grid[nonant]->fld[lx][ly] = field(t, density, 0);
+ if (light_emitter_at(grid[nonant], lx, ly))
+  add_light_emitter(x, y);
  if (g != NULL && lx == g->u.posx && ly == g->u.posy &&
      grid[nonant]->fld[lx][ly].is_dangerous()) {
   g->cancel_activity_query("You're in a %s!",
@@ -2162,11 +2351,59 @@ void map::remove_field(const int x, const int y)
 
  const int lx = x % SEEX;
  const int ly = y % SEEY;
- if (grid[nonant]->fld[lx][ly].type != fd_null)
+ if (grid[nonant]->fld[lx][ly].type != fd_null) {
   grid[nonant]->field_count--;
+  grid[nonant]->live_fields[lx] &= ~(1 << ly);
+ }
  grid[nonant]->fld[lx][ly] = field();
 }
 
+void map::add_light_emitter(const int x, const int y)
+{
+ if (!INBOUNDS(x, y))
+  return;
+ std::vector<point> &lights = grid[int(x / SEEX) + int(y / SEEY) * my_MAPSIZE]->lights;
+ const point p(x % SEEX, y % SEEY);
+ for (int i = 0; i < lights.size(); i++) {
+  if (lights[i].x == p.x && lights[i].y == p.y)
+   return;
+ }
+ lights.push_back(p);
+}
+
+// Keep in step with the emitters light_map::build_ops() looks for
+bool map::light_emitter_at(const submap *sm, const int lx, const int ly) const
+{
+ const ter_id terrain = sm->ter[lx][ly];
+ if (terrain == t_lava || terrain == t_console || terrain == t_emergency_light)
+  return true;
+ switch (sm->fld[lx][ly].type) {
+  case fd_fire:
+  case fd_fire_vent:
+  case fd_flame_burst:
+  case fd_electricity:
+   return true;
+ }
+ const std::vector<item> &items = sm->itm[lx][ly];
+ for (int i = 0; i < items.size(); i++) {
+  if (items[i].type->id == itm_flashlight_on ||
+      items[i].type->id == itm_candle_lit)
+   return true;
+ }
+ return false;
+}
+
+void map::find_light_emitters(submap *sm)
+{
+ sm->lights.clear();
+ for (int lx = 0; lx < SEEX; lx++) {
+  for (int ly = 0; ly < SEEY; ly++) {
+   if (light_emitter_at(sm, lx, ly))
+    sm->lights.push_back(point(lx, ly));
+  }
+ }
+}
+
 computer* map::computer_at(const int x, const int y)
 {
  if (!INBOUNDS(x, y))
@@ -2244,8 +2481,7 @@ void map::draw(game *g, WINDOW* w, const point center)
     distance_to_look = DAYLIGHT_LEVEL;
    }
  
-   int diffx = (g->u.posx - center.x), diffy = (g->u.posy - center.y);
-   bool can_see = g->lm.sees(diffx, diffy, realx - center.x, realy - center.y, distance_to_look);
+   bool can_see = pl_sees(g->u.posx, g->u.posy, realx, realy, distance_to_look);
    lit_level lit = g->lm.at(realx - center.x, realy - center.y);
 
    if (OPTIONS[OPT_GRADUAL_NIGHT_LIGHT] > 0.) {
@@ -2400,11 +2636,202 @@ void map::drawsq(WINDOW* w, player &u, const int x, const int y, const bool inve
 }
 
 /*
-map::sees based off code by Steve Register [arns@arns.freeservers.com]
-http://roguebasin.roguelikedevelopment.org/index.php?title=Simple_Line_of_Sight
+sees() and clear_path() try each Bresenham line between two points, from the
+straightest to the most diagonal, until one is unobstructed.  Which of those
+lines actually reach the target, and which tiles they cross, depends only on
+the distances along the two axes, so for anything within RAY_TABLE_RANGE we
+look the lines up in a table instead of re-deriving them (and walking the ones
+that miss the target until they hit a wall) on every call.
 */
+struct bresenham_ray {
+ int tc;	// The tc that gives this line, as sees() reports it
+ std::bitset<RAY_TABLE_RANGE> minor_steps; // Bit i: step i+1 moves on both axes
+};
+
+struct bresenham_ray_set {
+ bool built;
+ std::vector<bresenham_ray> rays; // Lines that reach the target, in sees() order
+ std::vector<point> shared; // (step, minor offset) crossed by every line
+ bresenham_ray_set() : built (false) {};
+};
+
+// Indexed by distance along the major, then the minor, axis
+static bresenham_ray_set ray_table[RAY_TABLE_RANGE + 1][RAY_TABLE_RANGE + 1];
+
+// This replays the mostly-horizontal loop of sees_walk(), with x as the major
+// axis; the mostly-vertical loop is the same with the axes swapped.
+static bresenham_ray_set &ray_set(const int major, const int minor)
+{
+ bresenham_ray_set &set = ray_table[major][minor];
+ if (set.built)
+  return set;
+ set.built = true;
+ const int amaj = major << 1;
+ const int amin = minor << 1;
+ const int st = SGN(amin - (amaj >> 1));
+ std::vector<int> common_minor(major, 0);
+ for (int tc = abs(amin - (amaj >> 1)) * 2 + 1; tc >= -1; tc--) {
+  bresenham_ray ray;
+  std::vector<int> at_minor(major, 0);
+  int t = tc * st;
+  int pos = 0;
+  for (int step = 1; step <= major; step++) {
+   if (t > 0) {
+    pos++;
+    t -= amaj;
+    if (step < major)
+     ray.minor_steps.set(step - 1);
+   }
+   t += amin;
+   if (step < major)
+    at_minor[step] = pos;
+  }
+  if (pos != minor)
+   continue; // This line misses the target
+  ray.tc = tc * st;
+  if (set.rays.empty())
+   common_minor = at_minor;
+  else {
+   for (int step = 1; step < major; step++) {
+    if (common_minor[step] != at_minor[step])
+     common_minor[step] = -1;
+   }
+  }
+  set.rays.push_back(ray);
+ }
+ if (!set.rays.empty()) {
+  for (int step = 1; step < major; step++) {
+   if (common_minor[step] != -1)
+    set.shared.push_back(point(step, common_minor[step]));
+  }
+ }
+ return set;
+}
+
+void map::build_ray_table()
+{
+ static bool built = false;
+ if (built)
+  return;
+ built = true;
+// table_sees() only asks for a minor axis no longer than the major one
+ for (int major = 0; major <= RAY_TABLE_RANGE; major++) {
+  for (int minor = 0; minor <= major; minor++)
+   ray_set(major, minor);
+ }
+}
+
+// cost_min < 0 means we're testing transparency, as sees() does; otherwise
+// cost_min <= move_cost <= cost_max, as clear_path() does
+bool map::ray_clear(const int x, const int y, const int cost_min,
+                    const int cost_max, char * trans_buf)
+{
+ if (!INBOUNDS(x, y))
+  return false;
+ if (cost_min < 0)
+  return trans(x, y, trans_buf);
+ const int cost = move_cost(x, y);
+ return (cost >= cost_min && cost <= cost_max);
+}
+
+bool map::table_sees(const int Fx, const int Fy, const int Tx, const int Ty,
+                     int &tc, const int cost_min, const int cost_max,
+                     char * trans_buf)
+{
+ const int dx = Tx - Fx;
+ const int dy = Ty - Fy;
+// Which axis is major follows the branches in sees_walk()
+ const bool x_major = (abs(dx) > abs(dy));
+ const int major = (x_major ? abs(dx) : abs(dy));
+ const int minor = (x_major ? abs(dy) : abs(dx));
+ const int smaj = (x_major ? SGN(dx) : SGN(dy));
+ const int smin = (x_major ? SGN(dy) : SGN(dx));
+ bresenham_ray_set &set = ray_set(major, minor);
+ tc = -2; // What sees_walk() leaves behind when every line is blocked
+
+// Tiles every line crosses are checked first; if any is blocked, they all are
+ for (int i = 0; i < set.shared.size(); i++) {
+  const int a = set.shared[i].x * smaj, b = set.shared[i].y * smin;
+  if (!ray_clear(Fx + (x_major ? a : b), Fy + (x_major ? b : a),
+                 cost_min, cost_max, trans_buf))
+   return false;
+ }
+ for (int r = 0; r < set.rays.size(); r++) {
+  const bresenham_ray &ray = set.rays[r];
+  int a = 0, b = 0;
+  bool clear = true;
+  for (int step = 1; step < major && clear; step++) {
+   a += smaj;
+   if (ray.minor_steps[step - 1])
+    b += smin;
+   clear = ray_clear(Fx + (x_major ? a : b), Fy + (x_major ? b : a),
+                     cost_min, cost_max, trans_buf);
+  }
+  if (clear) {
+   tc = ray.tc;
+   return true;
+  }
+ }
+ return false;
+}
+
 bool map::sees(const int Fx, const int Fy, const int Tx, const int Ty,
                const int range, int &tc, char * trans_buf)
+{
+ const int adx = abs(Tx - Fx), ady = abs(Ty - Fy);
+ if (range >= 0 && (adx > range || ady > range))
+  return false;	// Out of range!
+ if ((adx == 0 && ady == 0) || adx > RAY_TABLE_RANGE || ady > RAY_TABLE_RANGE)
+  return sees_walk(Fx, Fy, Tx, Ty, range, tc, trans_buf);
+ return table_sees(Fx, Fy, Tx, Ty, tc, -1, -1, trans_buf);
+}
+
+bool map::clear_path(const int Fx, const int Fy, const int Tx, const int Ty,
+                     const int range, const int cost_min, const int cost_max, int &tc)
+{
+ const int adx = abs(Tx - Fx), ady = abs(Ty - Fy);
+ if (range >= 0 && (adx > range || ady > range))
+  return false;	// Out of range!
+ if ((adx == 0 && ady == 0) || adx > RAY_TABLE_RANGE || ady > RAY_TABLE_RANGE ||
+     cost_min < 0)
+  return clear_path_walk(Fx, Fy, Tx, Ty, range, cost_min, cost_max, tc);
+ return table_sees(Fx, Fy, Tx, Ty, tc, cost_min, cost_max, NULL);
+}
+
+// Times sees() against sees_walk() between random pairs of points, and
+// counts any pair on which they disagree; used by the debug menu.
+void map::los_benchmark(const int samples, int &table_ms, int &walk_ms,
+                        int &mismatches)
+{
+ std::vector<point> from, to;
+ for (int i = 0; i < samples; i++) {
+  from.push_back(point(rng(0, SEEX * my_MAPSIZE - 1), rng(0, SEEY * my_MAPSIZE - 1)));
+  to.push_back(point(from[i].x + rng(-RAY_TABLE_RANGE, RAY_TABLE_RANGE),
+                     from[i].y + rng(-RAY_TABLE_RANGE, RAY_TABLE_RANGE)));
+ }
+ std::vector<bool> table_seen(samples), walk_seen(samples);
+ std::vector<int> table_tc(samples), walk_tc(samples);
+ clock_t start = clock();
+ for (int i = 0; i < samples; i++)
+  table_seen[i] = sees(from[i].x, from[i].y, to[i].x, to[i].y, -1, table_tc[i]);
+ table_ms = int((clock() - start) * 1000 / CLOCKS_PER_SEC);
+ start = clock();
+ for (int i = 0; i < samples; i++)
+  walk_seen[i] = sees_walk(from[i].x, from[i].y, to[i].x, to[i].y, -1, walk_tc[i]);
+ walk_ms = int((clock() - start) * 1000 / CLOCKS_PER_SEC);
+ mismatches = 0;
+ for (int i = 0; i < samples; i++) {
+  if (table_seen[i] != walk_seen[i] || (table_seen[i] && table_tc[i] != walk_tc[i]))
+   mismatches++;
+ }
+}
+
+/*
+map::sees based off code by Steve Register [arns@arns.freeservers.com]
+http://roguebasin.roguelikedevelopment.org/index.php?title=Simple_Line_of_Sight
+*/
+bool map::sees_walk(const int Fx, const int Fy, const int Tx, const int Ty,
+                    const int range, int &tc, char * trans_buf)
 {
  const int dx = Tx - Fx;
  const int dy = Ty - Fy;
@@ -2466,8 +2893,9 @@ bool map::sees(const int Fx, const int Fy, const int Tx, const int Ty,
  return false; // Shouldn't ever be reached, but there it is.
 }
 
-bool map::clear_path(const int Fx, const int Fy, const int Tx, const int Ty,
-                     const int range, const int cost_min, const int cost_max, int &tc)
+bool map::clear_path_walk(const int Fx, const int Fy, const int Tx, const int Ty,
+                          const int range, const int cost_min, const int cost_max,
+                          int &tc)
 {
  const int dx = Tx - Fx;
  const int dy = Ty - Fy;
@@ -2531,6 +2959,163 @@ bool map::clear_path(const int Fx, const int Fy, const int Tx, const int Ty,
  return false; // Shouldn't ever be reached, but there it is.
 }
 
+/*
+build_fov is recursive shadowcasting as described at
+http://roguebasin.roguelikedevelopment.org/index.php?title=FOV_using_recursive_shadowcasting
+Each octant is scanned row by row outward from the origin; opaque tiles are
+visible themselves but narrow the slopes scanned in later rows.
+*/
+void map::build_fov(fov_map &fov, const int x, const int y)
+{
+// Transforms from octant-local (col, row) to map offsets
+ static const int mult[4][8] = {
+  {1,  0,  0, -1, -1,  0,  0,  1},
+  {0,  1, -1,  0,  0, -1,  1,  0},
+  {0,  1,  1,  0,  0, -1, -1,  0},
+  {1,  0,  0,  1, -1,  0,  0, -1}
+ };
+ memset(fov.seen, 0, sizeof(fov.seen));
+ fov.x = x;
+ fov.y = y;
+ fov.version = terrain_version;
+ if (!INBOUNDS(x, y))
+  return;
+ fov.seen[x][y] = true;
+ const int radius = std::max(std::max(x, SEEX * my_MAPSIZE - 1 - x),
+                             std::max(y, SEEY * my_MAPSIZE - 1 - y));
+ for (int oct = 0; oct < 8; oct++)
+  cast_fov_octant(fov, 1, 1.0f, 0.0f, radius,
+                  mult[0][oct], mult[1][oct], mult[2][oct], mult[3][oct]);
+}
+
+void map::cast_fov_octant(fov_map &fov, const int row, float start,
+                          const float end, const int radius,
+                          const int xx, const int xy, const int yx, const int yy)
+{
+ if (start < end)
+  return;
+ float new_start = 0.0f;
+ for (int j = row; j <= radius; j++) {
+  int dx = -j - 1;
+  const int dy = -j;
+  bool blocked = false;
+  while (dx <= 0) {
+   dx++;
+   const int x = fov.x + dx * xx + dy * xy;
+   const int y = fov.y + dx * yx + dy * yy;
+   const float l_slope = (dx - 0.5f) / (dy + 0.5f);
+   const float r_slope = (dx + 0.5f) / (dy - 0.5f);
+   if (start < r_slope)
+    continue;
+   else if (end > l_slope)
+    break;
+   const bool inbounds = INBOUNDS(x, y);
+   if (inbounds)
+    fov.seen[x][y] = true;
+   const bool opaque = !inbounds || !trans(x, y);
+   if (blocked) {
+    if (opaque) {
+     new_start = r_slope;
+     continue;
+    }
+    blocked = false;
+    start = new_start;
+   } else if (opaque && j < radius) {
+    blocked = true;
+    cast_fov_octant(fov, j + 1, start, l_slope, radius, xx, xy, yx, yy);
+    new_start = r_slope;
+   }
+  }
+  if (blocked)
+   break;
+ }
+}
+
+void map::build_seen_cache(const int x, const int y)
+{
+ build_fov(seen_cache, x, y);
+}
+
+bool map::pl_sees(const int Fx, const int Fy, const int Tx, const int Ty,
+                  const int range)
+{
+ if (!INBOUNDS(Tx, Ty))
+  return false;
+ if (range >= 0 && rl_dist(Fx, Fy, Tx, Ty) > range)
+  return false;	// Out of range!
+ if (Fx != seen_cache.x || Fy != seen_cache.y ||
+     seen_cache.version != terrain_version)
+  build_seen_cache(Fx, Fy);
+ return seen_cache.seen[Tx][Ty];
+}
+
+// Beyond this many distinct targets in one turn we just walk rays
+#define MAX_TARGET_FOVS 16
+
+bool map::target_sees(const int Fx, const int Fy, const int Tx, const int Ty,
+                      const int range)
+{
+ if (!INBOUNDS(Fx, Fy) || !INBOUNDS(Tx, Ty))
+  return false;
+ if (range >= 0 && rl_dist(Fx, Fy, Tx, Ty) > range)
+  return false;	// Out of range!
+ prepare_target_fov(Tx, Ty);
+ return target_sees(Fx, Fy, Tx, Ty, range, target_los_stats);
+}
+
+bool map::target_sees(const int Fx, const int Fy, const int Tx, const int Ty,
+                      const int range, los_stats &stats)
+{
+ if (!INBOUNDS(Fx, Fy) || !INBOUNDS(Tx, Ty))
+  return false;
+ if (range >= 0 && rl_dist(Fx, Fy, Tx, Ty) > range)
+  return false;	// Out of range!
+ if (Tx == seen_cache.x && Ty == seen_cache.y &&
+     seen_cache.version == terrain_version) {
+  stats.queries++;
+  return seen_cache.seen[Fx][Fy];
+ }
+ for (int i = 0; i < target_fovs_used; i++) {
+  if (target_fovs[i].x == Tx && target_fovs[i].y == Ty &&
+      target_fovs[i].version == terrain_version) {
+   stats.queries++;
+   return target_fovs[i].seen[Fx][Fy];
+  }
+ }
+ int tc;
+ return sees(Fx, Fy, Tx, Ty, range, tc);
+}
+
+void map::prepare_target_fov(const int Tx, const int Ty)
+{
+ if (!INBOUNDS(Tx, Ty))
+  return;
+ if (Tx == seen_cache.x && Ty == seen_cache.y &&
+     seen_cache.version == terrain_version)
+  return;
+ for (int i = 0; i < target_fovs_used; i++) {
+  if (target_fovs[i].x == Tx && target_fovs[i].y == Ty) {
+// Rebuilt in place if the terrain has changed since, e.g. a door was bashed
+   if (target_fovs[i].version != terrain_version) {
+    build_fov(target_fovs[i], Tx, Ty);
+    target_los_stats.fovs++;
+   }
+   return;
+  }
+ }
+ if (target_fovs_used >= MAX_TARGET_FOVS)
+  return; // sees() it is
+ if (target_fovs.size() <= target_fovs_used)
+  target_fovs.push_back(fov_map());
+ build_fov(target_fovs[target_fovs_used++], Tx, Ty);
+ target_los_stats.fovs++;
+}
+
+void map::clear_target_fovs()
+{
+ target_fovs_used = 0;
+}
+
 // Bash defaults to true.
 std::vector<point> map::route(const int Fx, const int Fy, const int Tx, const int Ty, const bool bash)
 {
@@ -2673,6 +3258,7 @@ void map::save(overmap *om, unsigned const int turn, const int x, const int y)
 
 void map::load(game *g, const int wx, const int wy, const bool update_vehicle)
 {
+ terrain_version++;
  for (int gridx = 0; gridx < my_MAPSIZE; gridx++) {
   for (int gridy = 0; gridy < my_MAPSIZE; gridy++) {
    if (!loadn(g, wx, wy, gridx, gridy, update_vehicle))
@@ -2701,6 +3287,7 @@ void map::shift(game *g, const int wx, const int wy, const int sx, const int sy)
   g->u.posy -= sy * SEEY;
  }
 
+ terrain_version++;
  // Clear vehicle list and rebuild after shift
  clear_vehicle_cache();
  vehicle_list.clear();
@@ -2823,6 +3410,9 @@ bool map::loadn(game *g, const int worldx, const int worldy, const int gridx, co
  submap *tmpsub = MAPBUFFER.lookup_submap(absx, absy, g->cur_om.posz);
  if (tmpsub) {
   grid[gridn] = tmpsub;
+  catch_up(g, tmpsub);
+  find_light_emitters(tmpsub);
+  find_active_items(tmpsub);
 
   // Update vehicle data
   for( std::vector<vehicle*>::iterator it = tmpsub->vehicles.begin(),
@@ -2897,7 +3487,7 @@ void map::spawn_monsters(game *g)
      tmp.faction_id = grid[n]->spawns[i].faction_id;
      tmp.mission_id = grid[n]->spawns[i].mission_id;
      if (grid[n]->spawns[i].name != "NONE")
-      tmp.unique_name = grid[n]->spawns[i].name;
+      tmp.set_unique_name(grid[n]->spawns[i].name);
      if (grid[n]->spawns[i].friendly)
       tmp.friendly = -1;
      int fx = mx + gx * SEEX, fy = my + gy * SEEY;
@@ -25,9 +25,12 @@
 #include "graffiti.h"
 
 #define MAPSIZE 11
+// sees() and clear_path() use precomputed lines up to this far apart
+#define RAY_TABLE_RANGE 64
 
 class player;
 class item;
+class rng_stream;
 struct itype;
 
 // TODO: This should be const& but almost no functions are const
@@ -41,6 +44,37 @@ struct position_wrapped {
 typedef position_wrapped<vehicle> wrapped_vehicle;
 typedef std::vector<wrapped_vehicle> VehicleList;
 
+// One submap's share of a rectangle of the map; see map::region()
+struct submap_span {
+ submap *sm;
+ int x, y;   // Map coordinates of sm's local (0, 0)
+ int lx1, ly1, lx2, ly2; // Inclusive local bounds of the rectangle within sm
+};
+typedef std::vector<submap_span> map_region;
+
+// A field of view from one origin; see map::build_fov()
+struct fov_map {
+ int x, y; // Origin; -1 if never built
+ int version; // map::terrain_version it was built from
+ bool seen[SEEX * MAPSIZE][SEEY * MAPSIZE];
+ fov_map() : x (-1), y (-1), version (-1) {};
+};
+
+// Counters for the per-turn monster line-of-sight cache; see map::target_sees()
+struct los_stats {
+ int queries; // sees() questions answered from a field of view
+ int fovs;    // Fields of view built to answer them
+ int walks;   // sees() calls still needed to pick a line to the chosen target
+
+ los_stats() : queries (0), fovs (0), walks (0) {};
+ void add(const los_stats &more)
+ {
+  queries += more.queries;
+  fovs += more.fovs;
+  walks += more.walks;
+ }
+};
+
 class map
 {
  public:
@@ -78,9 +112,41 @@ class map
 // clear_path is the same idea, but uses cost_min <= move_cost <= cost_max
  bool clear_path(const int Fx, const int Fy, const int Tx, const int Ty,
                  const int range, const int cost_min, const int cost_max, int &tc);
+// Times sees() against a plain Bresenham walk between (samples) random points
+ void los_benchmark(const int samples, int &table_ms, int &walk_ms,
+                    int &mismatches);
 // route() generates an A* best path; if bash is true, we can bash through doors
  std::vector<point> route(const int Fx, const int Fy, const int Tx, const int Ty,
                           const bool bash = true);
+// Field of view from (x, y) over the whole map, by recursive shadowcasting.
+// The result agrees with sees() in the open and on about 97% of tiles among
+// buildings; nearly all of the difference is tiles that sees() reaches by
+// skimming past the corner of an obstacle, which shadowcasting leaves hidden.
+ void build_fov(fov_map &fov, const int x, const int y);
+ void build_seen_cache(const int x, const int y); // The player's fov_map
+// Can (Fx, Fy) see (Tx, Ty) within (range)?  Answered from the seen cache,
+// which is rebuilt if it was computed from some other origin, or before the
+// terrain last changed (a door opened or closed, a wall bashed down).
+ bool pl_sees(const int Fx, const int Fy, const int Tx, const int Ty,
+              const int range);
+// Can a monster at (Fx, Fy) see a target at (Tx, Ty) within (range)?
+// Answered from a field of view built from the target's side, once per
+// target position per turn, so many monsters looking at the same player or
+// NPC share one scan.  Unlike sees(), no line is chosen.  A field of view
+// built before the terrain last changed is built again.
+ bool target_sees(const int Fx, const int Fy, const int Tx, const int Ty,
+                  const int range);
+// The same, but only from fields of view already built, falling back on
+// sees(); it changes nothing but stats, so it's safe from several threads
+ bool target_sees(const int Fx, const int Fy, const int Tx, const int Ty,
+                  const int range, los_stats &stats);
+// Builds the field of view target_sees() would want for a target at (Tx, Ty)
+ void prepare_target_fov(const int Tx, const int Ty);
+ void clear_target_fovs(); // Call once per turn, before monsters plan
+ los_stats target_los_stats;
+// Works out every line sees() can look up, rather than each as it's first
+// needed, so that it can then be called from several threads
+ static void build_ray_table();
 
 // vehicles
  VehicleList get_vehicles(const int sx, const int sy, const int ex, const int ey);
@@ -108,6 +174,7 @@ class map
 
 // Terrain
  ter_id& ter(const int x, const int y); // Terrain at coord (x, y); {x|y}=(0, SEE{X|Y}*3]
+ void ter_set(const int x, const int y, const ter_id new_terrain); // Use during play
  std::string tername(const int x, const int y); // Name of terrain at (x, y)
  std::string features(const int x, const int y); // Words relevant to terrain (sharp, etc)
  bool has_flag(const t_flag flag, const int x, const int y);  // checks terrain and vehicles
@@ -134,6 +201,14 @@ class map
 // Radiation
  int& radiation(const int x, const int y);	// Amount of radiation at (x, y);
 
+// Region iteration
+// Splits a rectangle, clipped to the map, into the part that falls in each
+// submap.  Whole-area passes can then loop over each submap's layers (ter,
+// itm, fld...) directly instead of paying for a grid lookup and bounds check
+// in ter()/i_at()/field_at() on every tile.  Spans come in submap order.
+ map_region region(const int x1, const int y1, const int x2, const int y2);
+ map_region region(const point center, const int radius);
+
 // Items
  std::vector<item>& i_at(int x, int y);
  item water_from(const int x, const int y);
@@ -160,10 +235,26 @@ class map
  bool add_field(game *g, const int x, const int y, const field_id t, const unsigned char density);
  void remove_field(const int x, const int y);
  bool process_fields(game *g);				// See fields.cpp
- bool process_fields_in_submap(game *g, const int gridn);	// See fields.cpp
+ field old_field_at(const int x, const int y); // As process_fields() began
  void step_in_field(const int x, const int y, game *g);		// See fields.cpp
  void mon_in_field(const int x, const int y, game *g, monster *z);	// See fields.cpp
 
+// Light emitters
+// Each submap lists the squares whose terrain, items or field may give off
+// light, so the light map need not search every square for them.  The list is
+// rebuilt when a submap is loaded; code that puts a light on a loaded square
+// by other means than add_item()/add_field() must call add_light_emitter().
+// Squares stay listed until light_emitter_at() says they no longer qualify.
+ void add_light_emitter(const int x, const int y);
+ bool light_emitter_at(const submap *sm, const int lx, const int ly) const;
+
+// Active items
+// Likewise each submap lists the squares that may hold an active item, so
+// process_active_items() need not look through every square's items.  Items
+// switched on where they lie, rather than arriving through add_item(), must
+// be registered with add_active_item().
+ void add_active_item(const int x, const int y);
+
 // Computers
  computer* computer_at(const int x, const int y);
 
@@ -178,10 +269,13 @@ class map
                   const int x2, const int y2, bool ongrass, const int turn);
 // put_items_from puts exactly num items, based on chances
  void put_items_from(items_location loc, const int num, const int x, const int y, const int turn = 0);
+// One item type from loc's list, weighted by rarity; NULL if nothing's there
+ itype *pick_item(items_location loc);
  void add_spawn(mon_id type, const int count, const int x, const int y, bool friendly = false,
                 const int faction_id = -1, const int mission_id = -1,
                 std::string name = "NONE");
  void add_spawn(monster *mon);
+ static spawn_point spawn_from(monster *mon); // What add_spawn(mon) would add
  void create_anomaly(const int cx, const int cy, artifact_natural_property prop);
  vehicle *add_vehicle(game *g, vhtype_id type, const int x, const int y, const int dir);
  computer* add_computer(const int x, const int y, std::string name, const int security);
@@ -190,8 +284,28 @@ class map
  std::set<vehicle*> vehicle_list;
  std::map< std::pair<int,int>, std::pair<vehicle*,int> > veh_cached_parts;
  bool veh_exists_at [SEEX * MAPSIZE][SEEY * MAPSIZE];
+// Bumped whenever terrain changes: by ter_set(), and on load and shift.  Cached
+// routes and fields of view check it to know when to re-validate themselves;
+// see npc::update_path() and pl_sees().  Writing through ter() doesn't bump
+// it, so that's only for building maps that aren't in play yet.
+ int terrain_version;
 
 protected:
+ void find_light_emitters(submap *sm);
+ void find_active_items(submap *sm);
+ void catch_up(game *g, submap *sm);
+ bool sees_walk(const int Fx, const int Fy, const int Tx, const int Ty,
+                const int range, int &tc, char * trans_buf = NULL);
+ bool clear_path_walk(const int Fx, const int Fy, const int Tx, const int Ty,
+                      const int range, const int cost_min, const int cost_max,
+                      int &tc);
+ bool table_sees(const int Fx, const int Fy, const int Tx, const int Ty, int &tc,
+                 const int cost_min, const int cost_max, char * trans_buf);
+ bool ray_clear(const int x, const int y, const int cost_min, const int cost_max,
+                char * trans_buf);
+ void cast_fov_octant(fov_map &fov, const int row, float start,
+                      const float end, const int radius, const int xx,
+                      const int xy, const int yx, const int yy);
  void saven(overmap *om, unsigned const int turn, const int x, const int y,
             const int gridx, const int gridy);
  bool loadn(game *g, const int x, const int y, const int gridx, const int gridy,
@@ -217,9 +331,70 @@ protected:
 
  std::vector <trap*> *traps;
  std::vector <itype_id> (*mapitems)[num_itloc];
+// Rarities of each list in mapitems; shared, since every map has the same
+// lists, and rebuilt if a list changes size
+ static alias_table item_picks[num_itloc];
 
  bool veh_in_active_range;
 
+ fov_map seen_cache;
+ std::vector<fov_map> target_fovs;
+ int target_fovs_used; // Entries of target_fovs built this turn
+
+// Everything a field does to another square or to the rest of the game,
+// picked by process_fields() from the fields as they stood at the start of
+// the turn and carried out by move_fields() once every submap is done
+ enum field_move_type {
+  move_drift,   // Gas drifts one density into the square
+  move_flare,   // Big flames make the fire there burn higher
+  move_ignite,  // Fire catches in the square
+  move_smoke,   // Fire puffs smoke into the square
+  move_vent,    // A gas vent pours toxic gas into the square
+  move_unscent, // Gas at (x, y) clears the scent around it
+  move_scorch,  // Fire damages the vehicle part at (x, y)
+  move_explode, // Fire sets off explosive terrain in the square
+  move_destroy, // Fire brings down the terrain at (x, y)
+  move_ash,     // Fire burns the terrain at (x, y) to ash
+  move_spark,   // Electricity jumps into the empty square
+  move_arc,     // Electricity builds up in the square, or jumps into it
+  move_splash,  // An acid vent sprays acid over the square
+  move_rift,    // A tear in reality lets something through into the square
+  move_push     // Rocks are thrown around between the push fields at (x, y)
+ };
+ struct field_move {
+  int x, y, tox, toy;
+  field_move_type what;
+  field_id type;
+  int density;
+  field_move(int fx, int fy, int tx, int ty, field_move_type w, field_id t,
+             int d = 1)
+   : x(fx), y(fy), tox(tx), toy(ty), what(w), type(t), density(d) {}
+ };
+// One submap's share of process_fields()
+ struct field_job {
+  int gridn;
+  unsigned short live[SEEX];       // Its live_fields at the start of the turn
+  int smoke[SEEX][SEEY];           // Smoke each fire made eating its fuel
+  std::vector<field_move> moves;
+ };
+ std::vector<field_job> field_jobs;
+ int field_job_count;
+ int field_turn;
+ std::vector<field> field_snapshot; // SEEX * SEEY per submap with fields
+ std::vector<bool> field_snapshot_live;
+ std::vector<field_move> field_moves; // All the jobs' moves, shuffled
+ static void fields_fuel_job(void *data, int index);   // See fields.cpp
+ static void fields_spread_job(void *data, int index); // See fields.cpp
+ static void fields_age_job(void *data, int index);    // See fields.cpp
+ void fields_fuel(field_job &job);                     // See fields.cpp
+ void fields_spread(field_job &job);                   // See fields.cpp
+ void fields_age(field_job &job);                      // See fields.cpp
+ void spread_gas(field_job &job, rng_stream &luck, field *cur, const int x,
+                 const int y, const int chance);       // See fields.cpp
+ void move_fields(game *g);                            // See fields.cpp
+ void push_items(game *g, const int x, const int y);   // See fields.cpp
+ bool brazier_at(const int x, const int y);
+
 private:
  submap* grid[MAPSIZE * MAPSIZE];
 };
@@ -200,11 +200,10 @@ void mapbuffer::load()
                 num_loaded, num_submaps);
   int locx, locy, locz, turn;
   submap* sm = new submap;
+  sm->field_count = 0;
+  memset(sm->live_fields, 0, sizeof(sm->live_fields));
   fin >> locx >> locy >> locz >> turn;
-  sm->turn_last_touched = turn;
-  int turndif = (master_game ? int(master_game->turn) - turn : 0);
-  if (turndif < 0)
-   turndif = 0;
+  sm->turn_last_touched = turn; // map::catch_up() works from this
 // Load terrain
   for (int j = 0; j < SEEY; j++) {
    for (int i = 0; i < SEEX; i++) {
@@ -222,9 +221,6 @@ void mapbuffer::load()
    for (int i = 0; i < SEEX; i++) {
     int radtmp;
     fin >> radtmp;
-    radtmp -= int(turndif / 100);	// Radiation slowly decays
-    if (radtmp < 0)
-     radtmp = 0;
     sm->rad[i][j] = radtmp;
    }
   }
@@ -239,24 +235,23 @@ void mapbuffer::load()
     getline(fin, databuff);
     it_tmp.load_info(databuff, master_game);
     sm->itm[itx][ity].push_back(it_tmp);
-    if (it_tmp.active)
-     sm->active_item_count++;
    } else if (string_identifier == "C") {
     getline(fin, databuff); // Clear out the endline
     getline(fin, databuff);
     int index = sm->itm[itx][ity].size() - 1;
     it_tmp.load_info(databuff, master_game);
     sm->itm[itx][ity][index].put_in(it_tmp);
-    if (it_tmp.active)
-     sm->active_item_count++;
    } else if (string_identifier == "T") {
     fin >> itx >> ity >> t;
     sm->trp[itx][ity] = trap_id(t);
    } else if (string_identifier == "F") {
     fields_here = true;
     fin >> itx >> ity >> t >> d >> a;
+    if (sm->fld[itx][ity].type == fd_null && field_id(t) != fd_null) {
+     sm->field_count++;
+     sm->live_fields[itx] |= 1 << ity;
+    }
     sm->fld[itx][ity] = field(field_id(t), d, a);
-    sm->field_count++;
    } else if (string_identifier == "S") {
     char tmpfriend;
     int tmpfac = -1, tmpmis = -1;
@@ -1,3 +1,6 @@
+#ifndef _MAPBUFFER_H_
+#define _MAPBUFFER_H_
+
 #include "map.h"
 #include "line.h"
 #include <map>
@@ -48,3 +51,5 @@ class mapbuffer
 };
   
 extern mapbuffer MAPBUFFER;
+
+#endif
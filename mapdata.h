@@ -731,12 +731,14 @@ struct submap {
  field			fld[SEEX][SEEY]; // Field on each square
  int			rad[SEEX][SEEY]; // Irradiation of each square
  graffiti graf[SEEX][SEEY]; // Graffiti on each square
- int active_item_count;
  int field_count;
+ unsigned short live_fields[SEEX]; // Bit y of [x] is set where fld[x][y] isn't fd_null
  int turn_last_touched;
  std::vector<spawn_point> spawns;
  std::vector<vehicle*> vehicles;
  computer comp;
+ std::vector<point> lights; // Squares that may give off light; see map::add_light_emitter()
+ std::vector<point> active_items; // Squares that may hold active items; see map::add_active_item()
 };
 
 std::ostream & operator<<(std::ostream &, const submap *);
@@ -86,8 +86,8 @@ void map::generate(game *g, overmap *om, int x, int y, int turn)
 //  function, we save the upper-left 4 submaps, and delete the rest.
  for (int i = 0; i < my_MAPSIZE * my_MAPSIZE; i++) {
   grid[i] = new submap;
-  grid[i]->active_item_count = 0;
   grid[i]->field_count = 0;
+  memset(grid[i]->live_fields, 0, sizeof(grid[i]->live_fields));
   grid[i]->turn_last_touched = turn;
   grid[i]->comp = computer();
   for (int x = 0; x < SEEX; x++) {
@@ -6619,32 +6619,20 @@ void map::post_process(game *g, unsigned zones)
 void map::place_items(items_location loc, int chance, int x1, int y1,
                       int x2, int y2, bool ongrass, int turn)
 {
- std::vector<itype_id> eligible = (*mapitems)[loc];
-
  if (chance >= 100 || chance <= 0) {
   debugmsg("map::place_items() called with an invalid chance (%d)", chance);
   return;
  }
- if (eligible.size() == 0) { // No items here! (Why was it called?)
+ if ((*mapitems)[loc].size() == 0) { // No items here! (Why was it called?)
   debugmsg("map::place_items() called for an empty items list (list #%d)", loc);
   return;
  }
 
- int item_chance = 0;	// # of items
- for (int i = 0; i < eligible.size(); i++)
-  item_chance += (*itypes)[eligible[i]]->rarity;
- int selection, randnum;
  int px, py;
  while (rng(0, 99) < chance) {
-  randnum = rng(1, item_chance);
-  selection = -1;
-  while (randnum > 0) {
-   selection++;
-   if (selection >= eligible.size())
-    debugmsg("OOB selection (%d of %d); randnum is %d, item_chance %d",
-             selection, eligible.size(), randnum, item_chance);
-   randnum -= (*itypes)[eligible[selection]]->rarity;
-  }
+  itype *type = pick_item(loc);
+  if (type == NULL)
+   return;
   int tries = 0;
   do {
    px = rng(x1, x2);
@@ -6656,12 +6644,11 @@ void map::place_items(items_location loc, int chance, int x1, int y1,
             (!ongrass && (ter(px, py) == t_dirt || ter(px, py) == t_grass))) &&
            tries < 20);
   if (tries < 20) {
-   add_item(px, py, (*itypes)[eligible[selection]], turn);
+   add_item(px, py, type, turn);
 // Guns in the home and behind counters are generated with their ammo
 // TODO: Make this less of a hack
-   if ((*itypes)[eligible[selection]]->is_gun() &&
-       (loc == mi_homeguns || loc == mi_behindcounter)) {
-    it_gun* tmpgun = dynamic_cast<it_gun*> ((*itypes)[eligible[selection]]);
+   if (type->is_gun() && (loc == mi_homeguns || loc == mi_behindcounter)) {
+    it_gun* tmpgun = dynamic_cast<it_gun*> (type);
     add_item(px, py, (*itypes)[default_ammo(tmpgun->ammo)], turn);
    }
   }
@@ -6670,24 +6657,33 @@ void map::place_items(items_location loc, int chance, int x1, int y1,
 
 void map::put_items_from(items_location loc, int num, int x, int y, int turn)
 {
- std::vector<itype_id> eligible = (*mapitems)[loc];
- int item_chance = 0;	// # of items
- for (int i = 0; i < eligible.size(); i++)
-  item_chance += (*itypes)[eligible[i]]->rarity;
-
  for (int i = 0; i < num; i++) {
-  int selection, randnum;
-  randnum = rng(1, item_chance);
-  selection = -1;
-  while (randnum > 0) {
-   selection++;
-   if (selection >= eligible.size())
-    debugmsg("OOB selection (%d of %d); randnum is %d, item_chance %d",
-             selection, eligible.size(), randnum, item_chance);
-   randnum -= (*itypes)[eligible[selection]]->rarity;
-  }
-  add_item(x, y, (*itypes)[eligible[selection]], turn);
+  itype *type = pick_item(loc);
+  if (type == NULL)
+   return;
+  add_item(x, y, type, turn);
+ }
+}
+
+alias_table map::item_picks[num_itloc];
+
+itype *map::pick_item(items_location loc)
+{
+ const std::vector<itype_id> &eligible = (*mapitems)[loc];
+ alias_table &picks = item_picks[loc];
+ if (picks.size() != eligible.size()) {
+  std::vector<int> rarities;
+  for (int i = 0; i < eligible.size(); i++)
+   rarities.push_back((*itypes)[eligible[i]]->rarity);
+  picks = alias_table(rarities);
+ }
+ const int selection = picks.pick();
+ if (selection == -1) {
+  debugmsg("Nothing to pick from items list #%d (%d items, none of them found)",
+           loc, eligible.size());
+  return NULL;
  }
+ return (*itypes)[eligible[selection]];
 }
 
 void map::add_spawn(mon_id type, int count, int x, int y, bool friendly,
@@ -6710,9 +6706,16 @@ void map::add_spawn(mon_id type, int count, int x, int y, bool friendly,
 }
 
 void map::add_spawn(monster *mon)
+{
+ spawn_point sp = spawn_from(mon);
+ add_spawn(sp.type, 1, sp.posx, sp.posy, sp.friendly, sp.faction_id,
+           sp.mission_id, sp.name);
+}
+
+spawn_point map::spawn_from(monster *mon)
 {
  int spawnx, spawny;
- std::string spawnname = (mon->unique_name == "" ? "NONE" : mon->unique_name);
+ std::string spawnname = (mon->unique_name() == "" ? "NONE" : mon->unique_name());
  if (mon->spawnmapx != -1) {
   spawnx = mon->spawnposx;
   spawny = mon->spawnposy;
@@ -6726,8 +6729,8 @@ void map::add_spawn(monster *mon)
   spawny += SEEY;
  spawnx %= SEEX;
  spawny %= SEEY;
- add_spawn(mon_id(mon->type->id), 1, spawnx, spawny, (mon->friendly < 0),
-           mon->faction_id, mon->mission_id, spawnname);
+ return spawn_point(mon_id(mon->type->id), 1, spawnx, spawny, mon->faction_id,
+                    mon->mission_id, (mon->friendly < 0), spawnname);
 }
 
 vehicle *map::add_vehicle(game *g, vhtype_id type, int x, int y, int dir)
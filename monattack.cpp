@@ -318,9 +318,9 @@ void mattack::growplants(game *g, monster *z)
    if (i == 0 && j == 0)
     j++;
    if (!g->m.has_flag(diggable, z->posx + i, z->posy + j) && one_in(4))
-    g->m.ter(z->posx + i, z->posy + j) = t_dirt;
+    g->m.ter_set(z->posx + i, z->posy + j, t_dirt);
    else if (one_in(3) && g->m.is_destructable(z->posx + i, z->posy + j))
-    g->m.ter(z->posx + i, z->posy + j) = t_dirtmound; // Destroy walls, &c
+    g->m.ter_set(z->posx + i, z->posy + j, t_dirtmound); // Destroy walls, &c
    else {
     if (one_in(4)) {	// 1 in 4 chance to grow a tree
      int mondex = g->mon_at(z->posx + i, z->posy + j);
@@ -361,9 +361,9 @@ void mattack::growplants(game *g, monster *z)
        g->active_npc[npcdex].hit(g, hit, side, 0, rng(10, 30));
       }
      }
-     g->m.ter(z->posx + i, z->posy + j) = t_tree_young;
+     g->m.ter_set(z->posx + i, z->posy + j, t_tree_young);
     } else if (one_in(3)) // If no tree, perhaps underbrush
-     g->m.ter(z->posx + i, z->posy + j) = t_underbrush;
+     g->m.ter_set(z->posx + i, z->posy + j, t_underbrush);
    }
   }
  }
@@ -373,7 +373,7 @@ void mattack::growplants(game *g, monster *z)
    for (int j = -5; j <= 5; j++) {
     if (i != 0 || j != 0) {
      if (g->m.ter(z->posx + i, z->posy + j) == t_tree_young)
-      g->m.ter(z->posx + i, z->posy + j) = t_tree; // Young tree => tree
+      g->m.ter_set(z->posx + i, z->posy + j, t_tree); // Young tree => tree
      else if (g->m.ter(z->posx + i, z->posy + j) == t_underbrush) {
 // Underbrush => young tree
       int mondex = g->mon_at(z->posx + i, z->posy + j);
@@ -551,9 +551,9 @@ void mattack::triffid_heartbeat(game *g, monster *z)
   for (int x = g->u.posx; x <= z->posx - 3; x++) {
    for (int y = g->u.posy; y <= z->posy - 3; y++) {
     if (g->is_empty(x, y) && one_in(4))
-     g->m.ter(x, y) = t_root_wall;
+     g->m.ter_set(x, y, t_root_wall);
     else if (g->m.ter(x, y) == t_root_wall && one_in(10))
-     g->m.ter(x, y) = t_dirt;
+     g->m.ter_set(x, y, t_dirt);
    }
   }
 // Open blank tiles as long as there's no possible route
@@ -562,7 +562,7 @@ void mattack::triffid_heartbeat(game *g, monster *z)
          tries < 20) {
    int x = rng(g->u.posx, z->posx - 3), y = rng(g->u.posy, z->posy - 3);
    tries++;
-   g->m.ter(x, y) = t_dirt;
+   g->m.ter_set(x, y, t_dirt);
    if (rl_dist(x, y, g->u.posx, g->u.posy > 3 && g->z.size() < 30 &&
        g->mon_at(x, y) == -1 && one_in(20))) { // Spawn an extra monster
     mon_id montype = mon_triffid;
@@ -691,8 +691,7 @@ void mattack::leap(game *g, monster *z)
  z->sp_timeout = z->type->sp_freq;	// Reset timer
  point chosen = options[rng(0, options.size() - 1)];
  bool seen = g->u_see(z, linet); // We can see them jump...
- z->posx = chosen.x;
- z->posy = chosen.y;
+ z->setpos(g, chosen.x, chosen.y);
  seen |= g->u_see(z, linet); // ... or we can see them land
  if (seen)
   g->add_msg("The %s leaps!", z->name().c_str());
@@ -978,12 +977,10 @@ void mattack::vortex(game *g, monster *z)
        if (g->z[monhit].hurt(damage))
         g->kill_mon(monhit, (z->friendly != 0));
        hit_wall = true;
-       thrown->posx = traj[i - 1].x;
-       thrown->posy = traj[i - 1].y;
+       thrown->setpos(g, traj[i - 1].x, traj[i - 1].y);
       } else if (g->m.move_cost(traj[i].x, traj[i].y) == 0) {
        hit_wall = true;
-       thrown->posx = traj[i - 1].x;
-       thrown->posy = traj[i - 1].y;
+       thrown->setpos(g, traj[i - 1].x, traj[i - 1].y);
       }
       int damage_copy = damage;
       g->m.shoot(g, traj[i].x, traj[i].y, damage_copy, false, 0);
@@ -993,8 +990,7 @@ void mattack::vortex(game *g, monster *z)
      if (hit_wall)
       damage *= 2;
      else {
-      thrown->posx = traj[traj.size() - 1].x;
-      thrown->posy = traj[traj.size() - 1].y;
+      thrown->setpos(g, traj[traj.size() - 1].x, traj[traj.size() - 1].y);
      }
      if (thrown->hurt(damage))
       g->kill_mon(g->mon_at(thrown->posx, thrown->posy), (z->friendly != 0));
@@ -1070,7 +1066,7 @@ void mattack::stare(game *g, monster *z)
        g->m.ter(sight[i].x, sight[i].y) == t_reinforced_glass_v)
     i = sight.size();
    else if (g->m.is_destructable(sight[i].x, sight[i].y))
-    g->m.ter(sight[i].x, sight[i].y) = t_rubble;
+    g->m.ter_set(sight[i].x, sight[i].y, t_rubble);
   }
  }
 }
@@ -1126,13 +1122,12 @@ void mattack::smg(game *g, monster *z)
  int t, j, fire_t;
  if (z->friendly != 0) { // Attacking monsters, not the player!
   monster* target = NULL;
-  int closest = 19;
-  for (int i = 0; i < g->z.size(); i++) {
-   int dist = rl_dist(z->posx, z->posy, g->z[i].posx, g->z[i].posy);
-   if (g->z[i].friendly == 0 && dist < closest && 
-       g->m.sees(z->posx, z->posy, g->z[i].posx, g->z[i].posy, 18, t)) {
-    target = &(g->z[i]);
-    closest = dist;
+  std::vector<int> nearby = g->nearest_mons(z->posx, z->posy, 18);
+  for (int n = 0; n < nearby.size() && target == NULL; n++) {
+   monster *mon = &(g->z[nearby[n]]);
+   if (mon->friendly == 0 &&
+       g->m.sees(z->posx, z->posy, mon->posx, mon->posy, 18, t)) {
+    target = mon;
     fire_t = t;
    }
   }
@@ -1287,11 +1282,10 @@ void mattack::generator(game *g, monster *z)
 
 void mattack::upgrade(game *g, monster *z)
 {
- std::vector<int> targets;
- for (int i = 0; i < g->z.size(); i++) {
-  if (g->z[i].type->id == mon_zombie &&
-      rl_dist(z->posx, z->posy, g->z[i].posx, g->z[i].posy) <= 5)
-   targets.push_back(i);
+ std::vector<int> targets, nearby = g->mons_in_radius(z->posx, z->posy, 5);
+ for (int n = 0; n < nearby.size(); n++) {
+  if (g->z[nearby[n]].type->id == mon_zombie)
+   targets.push_back(nearby[n]);
  }
  if (targets.empty())
   return;
@@ -1336,13 +1330,9 @@ void mattack::breathe(game *g, monster *z)
 
  bool able = (z->type->id == mon_breather_hub);
  if (!able) {
-  for (int x = z->posx - 3; x <= z->posx + 3 && !able; x++) {
-   for (int y = z->posy - 3; y <= z->posy + 3 && !able; y++) {
-    int mondex = g->mon_at(x, y);
-    if (mondex != -1 && g->z[mondex].type->id == mon_breather_hub)
-     able = true;
-   }
-  }
+  std::vector<int> nearby = g->mons_in_radius(z->posx, z->posy, 3);
+  for (int n = 0; n < nearby.size() && !able; n++)
+   able = (g->z[nearby[n]].type->id == mon_breather_hub);
  }
  if (!able)
   return;
@@ -79,4 +79,11 @@ void game::init_monitems()
  monitems[mon_chickenbot]	= monitems[mon_eyebot];
  monitems[mon_tankbot]		= monitems[mon_eyebot];
  monitems[mon_turret]		= monitems[mon_eyebot];
+
+ for (int i = 0; i < num_monsters; i++) {
+  std::vector<int> chances;
+  for (int j = 0; j < monitems[i].size(); j++)
+   chances.push_back(monitems[i][j].chance);
+  monitem_picks[i] = alias_table(chances);
+ }
 }
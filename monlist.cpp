@@ -0,0 +1,94 @@
+#include "monlist.h"
+
+void monster_list::reserve(int n)
+{
+ mons.reserve(n);
+ slot_of.reserve(n);
+}
+
+void monster_list::push_back(const monster &mon)
+{
+ int slot;
+ if (free_slots.empty()) {
+  slot = index_of.size();
+  index_of.push_back(-1);
+  gens.push_back(0);
+ } else {
+  slot = free_slots.back();
+  free_slots.pop_back();
+ }
+ index_of[slot] = mons.size();
+ slot_of.push_back(slot);
+ mons.push_back(mon);
+}
+
+void monster_list::release(int slot)
+{
+ index_of[slot] = -1;
+ gens[slot]++;
+ free_slots.push_back(slot);
+}
+
+void monster_list::remove(int i)
+{
+ const int last = mons.size() - 1;
+ release(slot_of[i]);
+ if (i != last) {
+  mons[i] = mons[last];
+  slot_of[i] = slot_of[last];
+  index_of[slot_of[i]] = i;
+ }
+ mons.pop_back();
+ slot_of.pop_back();
+}
+
+// One pass that slides the survivors down, rather than erasing the dead one by
+// one; monsters still move in the same order afterwards.
+int monster_list::remove_dead()
+{
+ int kept = 0;
+ for (int i = 0; i < mons.size(); i++) {
+  if (mons[i].dead || mons[i].hp <= 0) {
+   release(slot_of[i]);
+   continue;
+  }
+  if (kept != i) {
+   mons[kept] = mons[i];
+   slot_of[kept] = slot_of[i];
+   index_of[slot_of[kept]] = kept;
+  }
+  kept++;
+ }
+ const int removed = mons.size() - kept;
+ if (removed > 0) {
+  mons.erase(mons.begin() + kept, mons.end());
+  slot_of.resize(kept);
+ }
+ return removed;
+}
+
+void monster_list::clear()
+{
+ for (int i = 0; i < slot_of.size(); i++)
+  release(slot_of[i]);
+ mons.clear();
+ slot_of.clear();
+}
+
+mon_handle monster_list::handle(int i) const
+{
+ return mon_handle(slot_of[i], gens[slot_of[i]]);
+}
+
+int monster_list::index(mon_handle h) const
+{
+ if (h.slot < 0 || h.slot >= index_of.size() || gens[h.slot] != h.gen)
+  return -1;
+ return index_of[h.slot];
+}
+
+monster *monster_list::find(mon_handle h)
+{
+ const int i = index(h);
+ return (i == -1 ? NULL : &mons[i]);
+}
@@ -0,0 +1,52 @@
+#ifndef _MONLIST_H_
+#define _MONLIST_H_
+
+#include "monster.h"
+#include <vector>
+
+// Names a monster in a monster_list for as long as it's there, however the
+// list is reordered.  Once the monster is removed the handle goes stale, and
+// never comes to name some other monster that took its place.
+struct mon_handle {
+ int slot;
+ int gen;
+ mon_handle() : slot(-1), gen(0) {}
+ mon_handle(int s, int g) : slot(s), gen(g) {}
+ bool operator==(const mon_handle &b) const { return slot == b.slot && gen == b.gen; }
+ bool operator!=(const mon_handle &b) const { return !(*this == b); }
+};
+
+// The monsters on the map, kept packed together for looping over.  It can be
+// indexed like the vector it replaces, but removing a monster is O(1): the
+// last monster is moved into its place, so the indices of other monsters can
+// change.  Anything that needs to find a monster again later, after monsters
+// may have been removed, should keep a mon_handle instead.
+class monster_list
+{
+ public:
+  size_t size() const { return mons.size(); }
+  bool empty() const { return mons.empty(); }
+  monster &operator[](int i) { return mons[i]; }
+  const monster &operator[](int i) const { return mons[i]; }
+
+  void reserve(int n);
+  void push_back(const monster &mon);
+  void remove(int i);
+  int remove_dead(); // Removes everything dead or at 0 HP, keeping the order
+  void clear();
+
+  mon_handle handle(int i) const;
+  int index(mon_handle h) const; // -1 if the monster's gone
+  monster *find(mon_handle h);   // NULL if the monster's gone
+
+ private:
+  void release(int slot);
+
+  std::vector<monster> mons;
+  std::vector<int> slot_of;    // By index in mons
+  std::vector<int> index_of;   // By slot; -1 for a free slot
+  std::vector<int> gens;       // By slot; bumped each time it's freed
+  std::vector<int> free_slots;
+};
+
+#endif
@@ -56,9 +56,8 @@ bool monster::can_move_to(map &m, int x, int y)
 // circumstance (or else the monster will "phase" through solid terrain!)
 void monster::set_dest(int x, int y, int &t)
 { 
- plans.clear();
 // TODO: This causes a segfault, once in a blue moon!  Whyyyyy.
- plans = line_to(posx, posy, x, y, t);
+ line_to(posx, posy, x, y, t, plans);
 }
 
 // Move towards (x,y) for f more turns--generally if we hear a sound there
@@ -72,7 +71,11 @@ void monster::wander_to(int x, int y, int f)
   wandf *= 6;
 }
 
-void monster::plan(game *g)
+// Only our own plans, feelings and scratch change here, and only caches built
+// beforehand are read, so hostile monsters can plan on several threads at
+// once; see game::plan_monsters().  Pets may grow restless, which others can
+// see, so they plan first, one at a time.
+void monster::plan(game *g, rng_stream &dice, plan_scratch &scratch)
 {
  int sightrange = g->light_level();
  int closest = -1;
@@ -80,12 +83,13 @@ void monster::plan(game *g)
  int tc, stc;
  bool fleeing = false;
  if (friendly != 0) {	// Target monsters, not the player!
-  for (int i = 0; i < g->z.size(); i++) {
-   monster *tmp = &(g->z[i]);
-   if (tmp->friendly == 0 && rl_dist(posx, posy, tmp->posx, tmp->posy) < dist &&
+  std::vector<int> &nearby = scratch.nearby;
+  g->nearest_mons(posx, posy, sightrange, nearby);
+  for (int n = 0; n < nearby.size() && closest == -1; n++) {
+   monster *tmp = &(g->z[nearby[n]]);
+   if (tmp->friendly == 0 &&
        g->m.sees(posx, posy, tmp->posx, tmp->posy, sightrange, tc)) {
-    closest = i;
-    dist = rl_dist(posx, posy, tmp->posx, tmp->posy);
+    closest = nearby[n];
     stc = tc;
    }
   }
@@ -93,7 +97,7 @@ void monster::plan(game *g)
    closest = -1;
   if (closest >= 0)
    set_dest(g->z[closest].posx, g->z[closest].posy, stc);
-  else if (friendly > 0 && one_in(3))	// Grow restless with no targets
+  else if (friendly > 0 && dice.one_in(3))	// Grow restless with no targets
    friendly--;
   else if (friendly < 0 && g->sees_u(posx, posy, tc)) {
    if (rl_dist(posx, posy, g->u.posx, g->u.posy) > 2)
@@ -103,7 +107,7 @@ void monster::plan(game *g)
   }
   return;
  }
- if (is_fleeing(g->u) && can_see() && g->sees_u(posx, posy, tc)) {
+ if (is_fleeing(g->u) && can_see() && g->sees_u(posx, posy, scratch.los)) {
   fleeing = true;
   wandx = posx * 2 - g->u.posx;
   wandy = posy * 2 - g->u.posy;
@@ -111,60 +115,94 @@ void monster::plan(game *g)
   dist = rl_dist(posx, posy, g->u.posx, g->u.posy);
  }
 // If we can see, and we can see a character, start moving towards them
- if (!is_fleeing(g->u) && can_see() && g->sees_u(posx, posy, tc)) {
+ if (!is_fleeing(g->u) && can_see() && g->sees_u(posx, posy, scratch.los)) {
   dist = rl_dist(posx, posy, g->u.posx, g->u.posy);
   closest = -2;
-  stc = tc;
  }
  for (int i = 0; i < g->active_npc.size(); i++) {
   npc *me = &(g->active_npc[i]);
   int medist = rl_dist(posx, posy, me->posx, me->posy);
   if ((medist < dist || (!fleeing && is_fleeing(*me))) &&
       (can_see() &&
-       g->m.sees(posx, posy, me->posx, me->posy, sightrange, tc))) {
+       g->m.target_sees(posx, posy, me->posx, me->posy, sightrange,
+                        scratch.los))) {
    if (is_fleeing(*me)) {
     fleeing = true;
     wandx = posx * 2 - me->posx;
     wandy = posy * 2 - me->posy;
     wandf = 40;
     dist = medist;
-   } else if (can_see() &&
-              g->m.sees(posx, posy, me->posx, me->posy, sightrange, tc)) {
+   } else {
     dist = rl_dist(posx, posy, me->posx, me->posy);
     closest = i;
-    stc = tc;
    }
   }
  }
  if (!fleeing) {
   fleeing = attitude() == MATT_FLEE;
-  for (int i = 0; i < g->z.size(); i++) {
-   monster *mon = &(g->z[i]);
-   int mondist = rl_dist(posx, posy, mon->posx, mon->posy);
-   if (mon->friendly != 0 && mondist < dist && can_see() &&
-       g->m.sees(posx, posy, mon->posx, mon->posy, sightrange, tc)) {
-    dist = mondist;
+// The nearest pet we can see, if it's closer than anyone else
+  std::vector<int> &nearby = scratch.nearby;
+  nearby.clear();
+  if (can_see())
+   g->nearest_mons(posx, posy, std::min(dist - 1, sightrange), nearby);
+  for (int n = 0; n < nearby.size(); n++) {
+   monster *mon = &(g->z[nearby[n]]);
+   if (mon->friendly != 0 &&
+       g->m.target_sees(posx, posy, mon->posx, mon->posy, sightrange,
+                        scratch.los)) {
+    dist = rl_dist(posx, posy, mon->posx, mon->posy);
     if (fleeing) {
      wandx = posx * 2 - mon->posx;
      wandy = posy * 2 - mon->posy;
      wandf = 40;
-    } else {
-     closest = -3 - i;
-     stc = tc;
-    }
+    } else
+     closest = -3 - nearby[n];
+    break;
    }
   }
  }
- if (!fleeing) {
+ if (!fleeing && closest != -1) {
+  point target;
   if (closest == -2)
-   set_dest(g->u.posx, g->u.posy, stc);
+   target = point(g->u.posx, g->u.posy);
   else if (closest <= -3)
-   set_dest(g->z[-3 - closest].posx, g->z[-3 - closest].posy, stc);
-  else if (closest >= 0)
-   set_dest(g->active_npc[closest].posx, g->active_npc[closest].posy, stc);
+   target = point(g->z[-3 - closest].posx, g->z[-3 - closest].posy);
+  else
+   target = point(g->active_npc[closest].posx, g->active_npc[closest].posy);
+// Only now that we've settled on a target do we need an actual line to it
+  scratch.los.walks++;
+  if (!g->m.sees(posx, posy, target.x, target.y, -1, stc))
+   stc = 0;
+  set_dest(target.x, target.y, stc);
  }
 }
  
+// If a monster that planned before us means to step where we do, take another
+// step that gets us just as close, rather than queue up behind it.
+void monster::claim_step(game *g, rng_stream &dice)
+{
+ if (plans.empty() || friendly != 0 || g->claim(plans[0].x, plans[0].y))
+  return;
+ const point target = plans.back();
+ const int dist = rl_dist(plans[0].x, plans[0].y, target.x, target.y);
+ point steps[8];
+ int num_steps = 0;
+ for (int x = posx - 1; x <= posx + 1; x++) {
+  for (int y = posy - 1; y <= posy + 1; y++) {
+   if ((x != posx || y != posy) && !g->claimed(x, y) &&
+       rl_dist(x, y, target.x, target.y) <= dist &&
+       can_move_to(g->m, x, y) && g->creature_at(x, y).empty())
+    steps[num_steps++] = point(x, y);
+  }
+ }
+ if (num_steps == 0)
+  return; // Nowhere better; move() deals with whoever's in the way
+ const point step = steps[dice.rng(0, num_steps - 1)];
+ g->claim(step.x, step.y);
+ line_to(step.x, step.y, target.x, target.y, 0, plans);
+ plans.insert(plans.begin(), step);
+}
+
 // General movement.
 // Currently, priority goes:
 // 1) Special Attack
@@ -262,9 +300,10 @@ void monster::move(game *g)
 // Finished logic section.  By this point, we should have chosen a square to
 //  move to (moved = true).
  if (moved) {	// Actual effects of moving to the square we've chosen
-  mondex = g->mon_at(next.x, next.y);
-  int npcdex = g->npc_at(next.x, next.y);
-  if (next.x == g->u.posx && next.y == g->u.posy && type->melee_dice > 0)
+  creature_ref in_way = g->creature_at(next.x, next.y);
+  mondex = (in_way.type == CREATURE_MONSTER ? in_way.index : -1);
+  int npcdex = (in_way.type == CREATURE_NPC ? in_way.index : -1);
+  if (in_way.type == CREATURE_PLAYER && type->melee_dice > 0)
    hit_player(g, g->u);
   else if (mondex != -1 && g->z[mondex].type->species == species_hallu)
    g->kill_mon(mondex);
@@ -341,13 +380,14 @@ void monster::friendly_move(game *g)
  } else
   stumble(g, moved);
  if (moved) {
-  int mondex = g->mon_at(next.x, next.y);
-  int npcdex = g->npc_at(next.x, next.y);
+  creature_ref in_way = g->creature_at(next.x, next.y);
+  int mondex = (in_way.type == CREATURE_MONSTER ? in_way.index : -1);
+  int npcdex = (in_way.type == CREATURE_NPC ? in_way.index : -1);
   if (mondex != -1 && g->z[mondex].friendly == 0 && type->melee_dice > 0)
    hit_monster(g, mondex);
   else if (npcdex != -1 && type->melee_dice > 0)
-   hit_player(g, g->active_npc[g->npc_at(next.x, next.y)]);
-  else if (mondex == -1 && npcdex == -1 && can_move_to(g->m, next.x, next.y))
+   hit_player(g, g->active_npc[npcdex]);
+  else if (in_way.empty() && can_move_to(g->m, next.x, next.y))
    move_to(g, next.x, next.y);
   else if ((!can_move_to(g->m, next.x, next.y) || one_in(3)) &&
            g->m.has_flag(bashable, next.x, next.y) && has_flag(MF_BASHES)) {
@@ -557,18 +597,12 @@ void monster::hit_player(game *g, player &p, bool can_grab)
  }
 // Adjust anger/morale of same-species monsters, if appropriate
  int anger_adjust = 0, morale_adjust = 0;
- for (int i = 0; i < type->anger.size(); i++) {
-  if (type->anger[i] == MTRIG_FRIEND_ATTACKED)
-   anger_adjust += 15;
- }
- for (int i = 0; i < type->placate.size(); i++) {
-  if (type->placate[i] == MTRIG_FRIEND_ATTACKED)
-   anger_adjust -= 15;
- }
- for (int i = 0; i < type->fear.size(); i++) {
-  if (type->fear[i] == MTRIG_FRIEND_ATTACKED)
-   morale_adjust -= 15;
- }
+ if (type->bitanger[MTRIG_FRIEND_ATTACKED])
+  anger_adjust += 15;
+ if (type->bitplacate[MTRIG_FRIEND_ATTACKED])
+  anger_adjust -= 15;
+ if (type->bitfear[MTRIG_FRIEND_ATTACKED])
+  morale_adjust -= 15;
  if (anger_adjust != 0 && morale_adjust != 0) {
   for (int i = 0; i < g->z.size(); i++) {
    g->z[i].morale += morale_adjust;
@@ -592,8 +626,7 @@ void monster::move_to(game *g, int x, int y)
   if (!has_flag(MF_DIGS) && !has_flag(MF_FLIES) &&
       (!has_flag(MF_SWIMS) || !g->m.has_flag(swimmable, x, y)))
    moves -= (g->m.move_cost(x, y) - 2) * 50;
-  posx = x;
-  posy = y;
+  setpos(g, x, y);
   footsteps(g, x, y);
   if (g->m.has_flag(sharp, posx, posy) && one_in(2))
      hurt(rng(3, 10));
@@ -609,7 +642,7 @@ void monster::move_to(game *g, int x, int y)
   }
 // Diggers turn the dirt into dirtmound
   if (has_flag(MF_DIGS))
-   g->m.ter(posx, posy) = t_dirtmound;
+   g->m.ter_set(posx, posy, t_dirtmound);
 // Acid trail monsters leave... a trail of acid
   if (has_flag(MF_ACIDTRAIL))
    g->m.add_field(g, posx, posy, fd_acid, 1);
@@ -626,21 +659,19 @@ void monster::move_to(game *g, int x, int y)
  */
 void monster::stumble(game *g, bool moved)
 {
- std::vector <point> valid_stumbles;
+ point valid_stumbles[9];
+ int num_stumbles = 0;
  for (int i = -1; i <= 1; i++) {
   for (int j = -1; j <= 1; j++) {
    if (can_move_to(g->m, posx + i, posy + j) &&
        (g->u.posx != posx + i || g->u.posy != posy + j) && 
-       (g->mon_at(posx + i, posy + j) == -1 || (i == 0 && j == 0))) {
-    point tmp(posx + i, posy + j);
-    valid_stumbles.push_back(tmp);
-   }
+       (g->mon_at(posx + i, posy + j) == -1 || (i == 0 && j == 0)))
+    valid_stumbles[num_stumbles++] = point(posx + i, posy + j);
   }
  }
- if (valid_stumbles.size() > 0 && (one_in(8) || (!moved && one_in(3)))) {
-  int choice = rng(0, valid_stumbles.size() - 1);
-  posx = valid_stumbles[choice].x;
-  posy = valid_stumbles[choice].y;
+ if (num_stumbles > 0 && (one_in(8) || (!moved && one_in(3)))) {
+  int choice = rng(0, num_stumbles - 1);
+  setpos(g, valid_stumbles[choice].x, valid_stumbles[choice].y);
   if (!has_flag(MF_DIGS) || !has_flag(MF_FLIES))
    moves -= (g->m.move_cost(posx, posy) - 2) * 50;
 // Here we have to fix our plans[] list, trying to get back to the last point
@@ -736,10 +767,8 @@ void monster::knock_back_from(game *g, int x, int y)
                                            g->m.tername(to.x, to.y).c_str());
   }
 
- } else { // It's no wall
-  posx = to.x;
-  posy = to.y;
- }
+ } else // It's no wall
+  setpos(g, to.x, to.y);
 }
 
 
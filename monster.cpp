@@ -41,7 +41,8 @@ monster::monster()
  mission_id = -1;
  dead = false;
  made_footstep = false;
- unique_name = "";
+ planned = false;
+ lod = MLOD_FULL;
 }
 
 monster::monster(mtype *t)
@@ -67,7 +68,8 @@ monster::monster(mtype *t)
  mission_id = -1;
  dead = false;
  made_footstep = false;
- unique_name = "";
+ planned = false;
+ lod = MLOD_FULL;
 }
 
 monster::monster(mtype *t, int x, int y)
@@ -93,7 +95,8 @@ monster::monster(mtype *t, int x, int y)
  mission_id = -1;
  dead = false;
  made_footstep = false;
- unique_name = "";
+ planned = false;
+ lod = MLOD_FULL;
 }
 
 monster::~monster()
@@ -124,8 +127,8 @@ std::string monster::name()
   debugmsg ("monster::name empty type!");
   return std::string();
  }
- if (unique_name != "")
-  return type->name + ": " + unique_name;
+ if (unique_name() != "")
+  return type->name + ": " + unique_name();
  return type->name;
 }
 
@@ -246,11 +249,7 @@ nc_color monster::color_with_effects()
 
 bool monster::has_flag(m_flag f)
 {
- for (int i = 0; i < type->flags.size(); i++) {
-  if (type->flags[i] == f)
-   return true;
- }
- return false;
+ return type->bitflags[f];
 }
 
 bool monster::can_see()
@@ -314,6 +313,15 @@ void monster::debug(player &u)
  getch();
 }
 
+void monster::setpos(game *g, int x, int y)
+{
+ const int oldx = posx, oldy = posy;
+ posx = x;
+ posy = y;
+ planned = false;
+ g->mon_moved(this, oldx, oldy);
+}
+
 void monster::shift(int sx, int sy)
 {
  posx -= sx * SEEX;
@@ -379,40 +387,38 @@ monster_attitude monster::attitude(player *u)
 
 void monster::process_triggers(game *g)
 {
- anger += trigger_sum(g, &(type->anger));
- anger -= trigger_sum(g, &(type->placate));
+ anger += trigger_sum(g, type->bitanger);
+ anger -= trigger_sum(g, type->bitplacate);
  if (morale < 0) {
   if (morale < type->morale && one_in(20))
   morale++;
  } else
-  morale -= trigger_sum(g, &(type->fear));
+  morale -= trigger_sum(g, type->bitfear);
 }
 
 // This Adjustes anger/morale levels given a single trigger.
 void monster::process_trigger(monster_trigger trig, int amount)
 {
- for (int i = 0; i < type->anger.size(); i++) {
-  if (type->anger[i] == trig)
-   anger += amount;
- }
- for (int i = 0; i < type->placate.size(); i++) {
-  if (type->placate[i] == trig)
-   anger -= amount;
- }
- for (int i = 0; i < type->fear.size(); i++) {
-  if (type->fear[i] == trig)
-   morale -= amount;
- }
+ if (type->bitanger[trig])
+  anger += amount;
+ if (type->bitplacate[trig])
+  anger -= amount;
+ if (type->bitfear[trig])
+  morale -= amount;
 }
 
 
-int monster::trigger_sum(game *g, std::vector<monster_trigger> *triggers)
+int monster::trigger_sum(game *g, const std::bitset<N_MONSTER_TRIGGERS> &triggers)
 {
  int ret = 0;
  bool check_terrain = false, check_meat = false, check_fire = false;
- for (int i = 0; i < triggers->size(); i++) {
+ if (triggers.none())
+  return 0;
+ for (int i = 0; i < N_MONSTER_TRIGGERS; i++) {
+  if (!triggers[i])
+   continue;
 
-  switch ((*triggers)[i]) {
+  switch (monster_trigger(i)) {
   case MTRIG_TIME:
    if (one_in(20))
     ret++;
@@ -625,36 +631,19 @@ void monster::die(game *g)
  if (!dead)
   dead = true;
 // Drop goodies
- int total_chance = 0, total_it_chance, cur_chance, selected_location,
-     selected_item;
  bool animal_done = false;
- std::vector<items_location_and_chance> it = g->monitems[type->id];
- std::vector<itype_id> mapit;
+ const std::vector<items_location_and_chance> &it = g->monitems[type->id];
  if (type->item_chance != 0 && it.size() == 0)
   debugmsg("Type %s has item_chance %d but no items assigned!",
            type->name.c_str(), type->item_chance);
  else {
-  for (int i = 0; i < it.size(); i++)
-   total_chance += it[i].chance;
-
   while (rng(0, 99) < abs(type->item_chance) && !animal_done) {
-   cur_chance = rng(1, total_chance);
-   selected_location = -1;
-   while (cur_chance > 0) {
-    selected_location++;
-    cur_chance -= it[selected_location].chance;
-   }
-   total_it_chance = 0;
-   mapit = g->mapitems[it[selected_location].loc];
-   for (int i = 0; i < mapit.size(); i++)
-    total_it_chance += g->itypes[mapit[i]]->rarity;
-   cur_chance = rng(1, total_it_chance);
-   selected_item = -1;
-   while (cur_chance > 0) {
-    selected_item++;
-    cur_chance -= g->itypes[mapit[selected_item]]->rarity;
-   }
-   g->m.add_item(posx, posy, g->itypes[mapit[selected_item]], 0);
+   const int selected_location = g->monitem_picks[type->id].pick();
+   if (selected_location == -1)
+    break;
+   itype *drop = g->m.pick_item(it[selected_location].loc);
+   if (drop != NULL)
+    g->m.add_item(posx, posy, drop, 0);
    if (type->item_chance < 0)
     animal_done = true;	// Only drop ONE item.
   }
@@ -705,18 +694,12 @@ void monster::die(game *g)
  (md.*type->dies)(g, this);
 // If our species fears seeing one of our own die, process that
  int anger_adjust = 0, morale_adjust = 0;
- for (int i = 0; i < type->anger.size(); i++) {
-  if (type->anger[i] == MTRIG_FRIEND_DIED)
-   anger_adjust += 15;
- }
- for (int i = 0; i < type->placate.size(); i++) {
-  if (type->placate[i] == MTRIG_FRIEND_DIED)
-   anger_adjust -= 15;
- }
- for (int i = 0; i < type->fear.size(); i++) {
-  if (type->fear[i] == MTRIG_FRIEND_DIED)
-   morale_adjust -= 15;
- }
+ if (type->bitanger[MTRIG_FRIEND_DIED])
+  anger_adjust += 15;
+ if (type->bitplacate[MTRIG_FRIEND_DIED])
+  anger_adjust -= 15;
+ if (type->bitfear[MTRIG_FRIEND_DIED])
+  morale_adjust -= 15;
  if (anger_adjust != 0 && morale_adjust != 0) {
   int light = g->light_level();
   for (int i = 0; i < g->z.size(); i++) {
@@ -753,7 +736,7 @@ void monster::rem_effect(monster_effect_type effect)
 {
  for (int i = 0; i < effects.size(); i++) {
   if (effects[i].type == effect) {
-   effects.erase(effects.begin() + i);
+   effects.erase(i);
    i--;
   }
  }
@@ -787,7 +770,7 @@ void monster::process_effects(game *g)
   if (effects[i].duration == 0) {
    if (g->debugmon)
     debugmsg("Deleting");
-   effects.erase(effects.begin() + i);
+   effects.erase(i);
    i--;
   }
  }
@@ -835,5 +818,21 @@ void monster::make_friendly()
 
 void monster::add_item(item it)
 {
- inv.push_back(it);
+ extra.make().inv.push_back(it);
+}
+
+const std::vector<item> &monster::inv()
+{
+ static const std::vector<item> no_items;
+ return (extra.get() ? extra.get()->inv : no_items);
+}
+
+std::string monster::unique_name()
+{
+ return (extra.get() ? extra.get()->unique_name : "");
+}
+
+void monster::set_unique_name(std::string name)
+{
+ extra.make().unique_name = name;
 }
@@ -4,12 +4,15 @@
 #include "player.h"
 #include "mtype.h"
 #include "enums.h"
+#include "rng.h"
+#include "compact.h"
 #include <vector>
 
 class map;
 class player;
 class game;
 class item;
+struct plan_scratch;
 
 enum monster_effect_type {
 ME_NULL = 0,
@@ -37,13 +40,29 @@ MATT_ATTACK,
 NUM_MONSTER_ATTITUDES
 };
 
+// How much thinking a monster gets; see game::plan_monsters()
+enum monster_lod {
+MLOD_FULL = 0,	// Near the player, or can see them: plans and moves every turn
+MLOD_COARSE,	// Far off, but following a sound, scent or plan: every few turns
+MLOD_IDLE,	// Far off with nothing to go on: no AI until something arrives
+NUM_MLOD
+};
+
 struct monster_effect
 {
  monster_effect_type type;
  int duration;
+ monster_effect() : type (ME_NULL), duration (0) {}
  monster_effect(monster_effect_type T, int D) : type (T), duration (D) {}
 };
 
+// The few things only some monsters have, allocated the first time one's set
+struct monster_extras
+{
+ std::vector<item> inv;   // Inventory
+ std::string unique_name; // If we're unique
+};
+
 class monster {
  public:
  monster();
@@ -52,6 +71,7 @@ class monster {
  ~monster();
  void poly(mtype *t);
  void spawn(int x, int y); // All this does is moves the monster to x,y
+ void setpos(game *g, int x, int y); // Moves a monster already in g->z
 
 // Access
  std::string name(); 		// Returns the monster's formal name
@@ -83,7 +103,8 @@ class monster {
 				      // t determines WHICH Bresenham line
  void wander_to(int x, int y, int f); // Try to get to (x, y), we don't know
 				      // the route.  Give up after f steps.
- void plan(game *g);
+ void plan(game *g, rng_stream &dice, plan_scratch &scratch);
+ void claim_step(game *g, rng_stream &dice); // Reserve plans[0], or sidestep
  void move(game *g); // Actual movement
  void footsteps(game *g, int x, int y); // noise made by movement
  void friendly_move(game *g);
@@ -101,7 +122,7 @@ class monster {
  int morale_level(player &u);	// Looks at our HP etc.
  void process_triggers(game *g);// Process things that anger/scare us
  void process_trigger(monster_trigger trig, int amount);// Single trigger
- int trigger_sum(game *g, std::vector<monster_trigger> *triggers);
+ int trigger_sum(game *g, const std::bitset<N_MONSTER_TRIGGERS> &triggers);
  int  hit(game *g, player &p, body_part &bp_hit); // Returns a damage
  void hit_monster(game *g, int i);
  bool hurt(int dam); 	// Deals this dam damage; returns true if we dead
@@ -121,13 +142,15 @@ class monster {
 				// Returns false if no such monster exists
  void make_friendly();
  void add_item(item it);	// Add an item to inventory
+ const std::vector<item> &inv(); // Empty if we've never had anything
+ std::string unique_name();	// "" if we're not unique
+ void set_unique_name(std::string name);
 
 // TEMP VALUES
  int posx, posy;
  int wandx, wandy; // Wander destination - Just try to move in that direction
  int wandf;	   // Urge to wander - Increased by sound, decrements each move
- std::vector<item> inv; // Inventory
- std::vector<monster_effect> effects; // Active effects, e.g. on fire
+ small_vector<monster_effect, 2> effects; // Active effects, e.g. on fire
 
 // If we were spawned by the map, store our origin for later use
  int spawnmapx, spawnmapy, spawnposx, spawnposy;
@@ -141,11 +164,15 @@ class monster {
  int faction_id; // If we belong to a faction
  int mission_id; // If we're related to a mission
  mtype *type;
+ monster_lod lod;
  bool dead;
  bool made_footstep;
- std::string unique_name; // If we're unique
+ bool planned; // Has plans from game::plan_monsters(); cleared by setpos()
 
 private:
+ lazy_ptr<monster_extras> extra;
+// Refilled in place by set_dest(), so once a monster has chased something its
+// buffer is big enough for the next chase too
  std::vector <point> plans;
 };
 
@@ -5,6 +5,7 @@
 
 #include <string>
 #include <vector>
+#include <bitset>
 #include <math.h>
 #include "mondeath.h"
 #include "monattack.h"
@@ -172,6 +173,9 @@ struct mtype {
  std::vector<monster_trigger> anger;   // What angers us?
  std::vector<monster_trigger> placate; // What reduces our anger?
  std::vector<monster_trigger> fear;    // What are we afraid of?
+// The above as masks, for testing at run time; see set_bitmasks()
+ std::bitset<MF_MAX> bitflags;
+ std::bitset<N_MONSTER_TRIGGERS> bitanger, bitplacate, bitfear;
 
  unsigned char frequency;	// How often do these show up? 0 (never) to ??
  int difficulty;// Used all over; 30 min + (diff-3)*30 min = earlist appearance
@@ -265,13 +269,26 @@ struct mtype {
   fear = default_fears(species);
  }
 
+ // Must be called again whenever the flag or trigger vectors change
+ void set_bitmasks()
+ {
+  bitflags.reset();
+  for (int i = 0; i < flags.size(); i++)
+   bitflags.set(flags[i]);
+  bitanger.reset();
+  for (int i = 0; i < anger.size(); i++)
+   bitanger.set(anger[i]);
+  bitplacate.reset();
+  for (int i = 0; i < placate.size(); i++)
+   bitplacate.set(placate[i]);
+  bitfear.reset();
+  for (int i = 0; i < fear.size(); i++)
+   bitfear.set(fear[i]);
+ }
+
  bool has_flag(m_flag flag)
  {
-  for (int i = 0; i < flags.size(); i++) {
-   if (flags[i] == flag)
-    return true;
-  }
-  return false;
+  return bitflags[flag];
  }
 };
 
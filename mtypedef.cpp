@@ -1174,6 +1174,8 @@ away.  Defend it at all costs!"
 );
 FLAGS(MF_NOHEAD, MF_ACIDPROOF, MF_IMMOBILE);
 
+ for (int i = 0; i < mtypes.size(); i++)
+  mtypes[i]->set_bitmasks();
 }
 
 
@@ -37,6 +37,7 @@ npc::npc()
  fetching_item = false;
  has_new_items = false;
  worst_item_value = 0;
+ path_version = -1;
  str_max = 0;
  dex_max = 0;
  int_max = 0;
@@ -81,6 +82,7 @@ npc& npc::operator= (const npc & rhs)
  goaly = rhs.goaly;
 
  path = rhs.path;
+ path_version = rhs.path_version;
 
  fetching_item = rhs.fetching_item;
  has_new_items = rhs.has_new_items;
@@ -1658,9 +1660,11 @@ int npc::danger_assessment(game *g)
 {
  int ret = 0;
  int sightdist = g->light_level(), junk;
- for (int i = 0; i < g->z.size(); i++) {
-  if (g->m.sees(posx, posy, g->z[i].posx, g->z[i].posy, sightdist, junk))
-   ret += g->z[i].type->difficulty;
+ std::vector<int> nearby = g->mons_in_radius(posx, posy, sightdist);
+ for (int n = 0; n < nearby.size(); n++) {
+  monster *mon = &(g->z[nearby[n]]);
+  if (g->m.sees(posx, posy, mon->posx, mon->posy, sightdist, junk))
+   ret += mon->type->difficulty;
  }
  ret /= 10;
  if (ret <= 2)
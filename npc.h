@@ -389,6 +389,17 @@ struct npc_chatbin
  }
 };
 
+// Counters for the NPC path cache; see npc::update_path()
+struct npc_path_stats
+{
+ int hits;       // Cached path still led to the target
+ int extended;   // Target moved a little; path was trimmed, extended or spliced
+ int repaired;   // A blocked step was routed around locally
+ int recomputed; // A full map::route() was needed
+
+ npc_path_stats() : hits (0), extended (0), repaired (0), recomputed (0) {};
+};
+
 class npc : public player {
 
 public:
@@ -514,6 +525,9 @@ public:
 
 // Physical movement from one tile to the next
  void update_path	(game *g, int x, int y);
+ bool path_is_valid	(game *g); // Cached <path> still walkable from here?
+ bool splice_path	(game *g, int x, int y); // Patch <path> to a moved target
+ void repair_path	(game *g); // Route around a blocked step of <path>
  bool can_move_to	(game *g, int x, int y);
  void move_to		(game *g, int x, int y);
  void move_to_next	(game *g); // Next in <path>
@@ -569,6 +583,8 @@ public:
  int  worst_item_value; // The value of our least-wanted item
 
  std::vector<point> path;	// Our movement plans
+ int path_version;	// map::terrain_version when <path> was last checked
+ static npc_path_stats path_stats;
 
 
 // Personality & other defining characteristics
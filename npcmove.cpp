@@ -331,7 +331,10 @@ void npc::choose_monster_target(game *g, int &enemy, int &danger,
  int highest_priority = 0;
  total_danger = 0;
 
- for (int i = 0; i < g->z.size(); i++) {
+ std::vector<int> nearby = g->mons_in_radius(posx, posy,
+                                              sight_range(g->light_level()));
+ for (int n = 0; n < nearby.size(); n++) {
+  const int i = nearby[n];
   monster *mon = &(g->z[i]);
   if (g->pl_sees(this, mon, linet)) {
    int distance = (100 * rl_dist(posx, posy, mon->posx, mon->posy)) /
@@ -838,18 +841,111 @@ bool npc::enough_time_to_reload(game *g, int target, item &gun)
  return (turns_til_reloaded < turns_til_reached);
 }
 
+// How far back along our path we look for a spot to splice a moved target onto
+#define NPC_PATH_SPLICE_DIST 4
+// How far ahead along our path we look for a spot to rejoin after an obstacle
+#define NPC_PATH_REPAIR_DIST 6
+
+npc_path_stats npc::path_stats;
+
 void npc::update_path(game *g, int x, int y)
 {
- if (path.empty()) {
-  path = g->m.route(posx, posy, x, y);
-  return;
+ if (!path.empty() && path_is_valid(g)) {
+  point last = path[path.size() - 1];
+  if (last.x == x && last.y == y) {
+   path_stats.hits++;
+   return; // Our path already leads to that point, no need to recalculate
+  }
+  if (splice_path(g, x, y)) {
+   path_stats.extended++;
+   return;
+  }
  }
- point last = path[path.size() - 1];
- if (last.x == x && last.y == y)
-  return; // Our path already leads to that point, no need to recalculate
+ path_stats.recomputed++;
  path = g->m.route(posx, posy, x, y);
  if (!path.empty() && path[0].x == posx && path[0].y == posy)
   path.erase(path.begin());
+ path_version = g->m.terrain_version;
+}
+
+// A cached path stays good as long as it starts next to us and none of its
+// steps has become impassable.  That only needs checking when the map reports
+// a terrain change; anything it misses is caught by repair_path().
+bool npc::path_is_valid(game *g)
+{
+ if (rl_dist(posx, posy, path[0].x, path[0].y) > 1)
+  return false;
+ if (path_version == g->m.terrain_version)
+  return true;
+ for (int i = 0; i < path.size(); i++) {
+  if (g->m.move_cost(path[i].x, path[i].y) == 0 &&
+      !g->m.has_flag(bashable, path[i].x, path[i].y))
+   return false;
+ }
+ path_version = g->m.terrain_version;
+ return true;
+}
+
+// Our target moved from the end of our path to (x, y).  If it's still close
+// to the tail of the path, trim or extend the path instead of replanning.
+bool npc::splice_path(game *g, int x, int y)
+{
+ point last = path[path.size() - 1];
+ if (rl_dist(last.x, last.y, x, y) > NPC_PATH_SPLICE_DIST)
+  return false;
+// Don't let repeated splicing wind the path around; a fresh route is shorter
+ if (path.size() > 2 * rl_dist(posx, posy, x, y) + NPC_PATH_SPLICE_DIST)
+  return false;
+// Walk back from the end; the first step adjacent to (x, y) becomes our new
+// second-to-last step.  We may also be adjacent to it ourselves.
+ int stop = path.size() - NPC_PATH_SPLICE_DIST;
+ for (int i = path.size() - 1; i >= -1 && i >= stop - 1; i--) {
+  point p = (i == -1 ? point(posx, posy) : path[i]);
+  if (p.x == x && p.y == y) {
+   path.erase(path.begin() + i + 1, path.end());
+   return true;
+  } else if (rl_dist(p.x, p.y, x, y) <= 1) {
+   path.erase(path.begin() + i + 1, path.end());
+   path.push_back(point(x, y));
+   return true;
+  }
+ }
+// Nothing adjacent; plan a short route from our old endpoint instead
+ std::vector<point> tail = g->m.route(last.x, last.y, x, y);
+ if (tail.empty())
+  return false;
+ if (tail[0].x == last.x && tail[0].y == last.y)
+  tail.erase(tail.begin());
+ path.insert(path.end(), tail.begin(), tail.end());
+ return true;
+}
+
+// The next step of our path is blocked by something we can neither walk
+// through nor bash; route to the first clear step further along and keep the
+// rest of the path.
+void npc::repair_path(game *g)
+{
+ int rejoin = -1;
+ for (int i = 1; i < path.size() && i <= NPC_PATH_REPAIR_DIST; i++) {
+  if (g->m.move_cost(path[i].x, path[i].y) > 0) {
+   rejoin = i;
+   break;
+  }
+ }
+ if (rejoin != -1) {
+  std::vector<point> detour = g->m.route(posx, posy, path[rejoin].x,
+                                         path[rejoin].y);
+  if (!detour.empty()) {
+   path_stats.repaired++;
+   path.erase(path.begin(), path.begin() + rejoin + 1);
+   path.insert(path.begin(), detour.begin(), detour.end());
+   return;
+  }
+ }
+ point dest = path[path.size() - 1];
+ path_stats.recomputed++;
+ path = g->m.route(posx, posy, dest.x, dest.y);
+ path_version = g->m.terrain_version;
 }
 
 bool npc::can_move_to(game *g, int x, int y)
@@ -891,16 +987,17 @@ void npc::move_to(game *g, int x, int y)
   x = newpath[0].x;
   y = newpath[0].y;
  }
+ creature_ref in_way = g->creature_at(x, y);
  if (x == posx && y == posy)	// We're just pausing!
   moves -= 100;
- else if (g->mon_at(x, y) != -1) {	// Shouldn't happen, but it might.
-  //monster *m = &(g->z[g->mon_at(x, y)]);
-  //debugmsg("Bumped into a monster, %d, a %s",g->mon_at(x, y),m->name().c_str());
-  melee_monster(g, g->mon_at(x, y));
- } else if (g->u.posx == x && g->u.posy == y) {
+ else if (in_way.type == CREATURE_MONSTER) {	// Shouldn't happen, but it might.
+  //monster *m = &(g->z[in_way.index]);
+  //debugmsg("Bumped into a monster, %d, a %s",in_way.index,m->name().c_str());
+  melee_monster(g, in_way.index);
+ } else if (in_way.type == CREATURE_PLAYER) {
   say(g, "<let_me_pass>");
   moves -= 100;
- } else if (g->npc_at(x, y) != -1)
+ } else if (in_way.type == CREATURE_NPC)
 // TODO: Determine if it's an enemy NPC (hit them), or a friendly in the way
   moves -= 100;
  else if (g->m.move_cost(x, y) > 0) {
@@ -927,8 +1024,14 @@ void npc::move_to_next(game *g)
   move_pause();
   return;
  }
- while (posx == path[0].x && posy == path[0].y)
+ while (!path.empty() && posx == path[0].x && posy == path[0].y)
   path.erase(path.begin());
+ if (path.size() > 1 && !can_move_to(g, path[0].x, path[0].y))
+  repair_path(g);
+ if (path.empty()) {
+  move_pause();
+  return;
+ }
  move_to(g, path[0].x, path[0].y);
  if (posx == path[0].x && posy == path[0].y) // Move was successful
   path.erase(path.begin());
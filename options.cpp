@@ -88,6 +88,10 @@ option_key lookup_option_key(std::string id)
   return OPT_DELETE_WORLD;
  if (id == "initial_points")
   return OPT_INITIAL_POINTS;
+ if (id == "scent_budget")
+  return OPT_SCENT_BUDGET;
+ if (id == "monster_ai_interval")
+  return OPT_MONSTER_AI_INTERVAL;
  return OPT_NULL;
 }
 
@@ -109,6 +113,8 @@ std::string option_string(option_key key)
   case OPT_SKILL_RUST: return "skill_rust";
   case OPT_DELETE_WORLD: return "delete_world";
   case OPT_INITIAL_POINTS: return "initial_points";
+  case OPT_SCENT_BUDGET: return "scent_budget";
+  case OPT_MONSTER_AI_INTERVAL: return "monster_ai_interval";
   default:			return "unknown_option";
  }
  return "unknown_option";
@@ -132,6 +138,8 @@ std::string option_desc(option_key key)
   case OPT_SKILL_RUST: return "Set the level of skill rust\n0 - vanilla Cataclysm\n1 - capped at skill levels\n2 - none at all";
   case OPT_DELETE_WORLD: return "Delete saves upon player death\n0 - no\n1 - yes\n2 - query";
   case OPT_INITIAL_POINTS: return "Initial points available on character generation.\nDefault is 6";
+  case OPT_SCENT_BUDGET: return "Columns of the map that scent spreads over\neach turn far from you; lower is faster on\nslow machines but far scent goes stale.\nDefault is 4; 0 also means 4";
+  case OPT_MONSTER_AI_INTERVAL: return "Monsters far away that can't see you only\nthink every this many turns; 1 gives\nevery monster full AI every turn.\nDefault is 4";
   default:			return " ";
  }
  return "Big ol Bug";
@@ -155,6 +163,8 @@ std::string option_name(option_key key)
   case OPT_SKILL_RUST: return "Skill Rust";
   case OPT_DELETE_WORLD: return "Delete World";
   case OPT_INITIAL_POINTS: return "Initial points";
+  case OPT_SCENT_BUDGET: return "Scent columns per turn";
+  case OPT_MONSTER_AI_INTERVAL: return "Distant monster AI interval";
   default:			return "Unknown Option (BUG)";
  }
  return "Big ol Bug";
@@ -167,6 +177,8 @@ bool option_is_bool(option_key id)
   case OPT_DROP_EMPTY:
   case OPT_DELETE_WORLD:
   case OPT_INITIAL_POINTS:
+  case OPT_SCENT_BUDGET:
+  case OPT_MONSTER_AI_INTERVAL:
     return false;
     break;
   default:
@@ -186,6 +198,12 @@ char option_max_options(option_key id)
       case OPT_INITIAL_POINTS:
         ret = 25;
         break;
+      case OPT_SCENT_BUDGET:
+        ret = 12; // Up to every column of the map
+        break;
+      case OPT_MONSTER_AI_INTERVAL:
+        ret = 11;
+        break;
       case OPT_DELETE_WORLD:
       case OPT_DROP_EMPTY:
       case OPT_SKILL_RUST:
@@ -239,6 +257,10 @@ skill_rust 0\n\
 delete_world 0\n\
 # Initial points available in character generation\n\
 initial_points 6\n\
+# Columns of submaps scent spreads over each turn far from the player\n\
+scent_budget 4\n\
+# Turns between AI updates for distant monsters that can't see you\n\
+monster_ai_interval 4\n\
 ";
  fout.close();
 }
@@ -20,6 +20,8 @@ OPT_DROP_EMPTY, // auto drop empty containers after use
 OPT_SKILL_RUST, // level of skill rust
 OPT_DELETE_WORLD,
 OPT_INITIAL_POINTS,
+OPT_SCENT_BUDGET, // Submap columns per turn for spreading scent far from the player
+OPT_MONSTER_AI_INTERVAL, // Turns between AI updates for distant monsters
 NUM_OPTION_KEYS
 };
 
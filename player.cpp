@@ -3264,7 +3264,7 @@ void player::process_active_items(game *g)
    debugmsg("%s is active, but it is not a tool.", weapon.tname().c_str());
    return;
   }
-  tmp = dynamic_cast<it_tool*>(weapon.type);
+  tmp = static_cast<it_tool*>(weapon.type);
   (use.*tmp->use)(g, this, &weapon, true);
   if (tmp->turns_per_charge > 0 && int(g->turn) % tmp->turns_per_charge == 0)
    weapon.charges--;
@@ -3276,13 +3276,17 @@ void player::process_active_items(game *g)
     weapon.type = g->itypes[tmp->revert_to];
   }
  }
- for (int i = 0; i < inv.size(); i++) {
-  for (int j = 0; j < inv.stack_at(i).size(); j++) {
+ // Only the stacks holding something active or an artifact, last first so
+ // that removing one doesn't move those still to come
+ const std::vector<int> stacks = inv.active_stacks();
+ for (int s = stacks.size() - 1; s >= 0; s--) {
+  const int i = stacks[s];
+  for (int j = 0; i < inv.size() && j < inv.stack_at(i).size(); j++) {
    item *tmp_it = &(inv.stack_at(i)[j]);
    if (tmp_it->is_artifact() && tmp_it->is_tool())
     g->process_artifact(tmp_it, this);
-   if (tmp_it->active) {
-    tmp = dynamic_cast<it_tool*>(tmp_it->type);
+   if (tmp_it->active && tmp_it->is_tool()) {
+    tmp = static_cast<it_tool*>(tmp_it->type);
     (use.*tmp->use)(g, this, tmp_it, true);
     if (tmp->turns_per_charge > 0 && int(g->turn) % tmp->turns_per_charge == 0)
     tmp_it->charges--;
@@ -3291,8 +3295,7 @@ void player::process_active_items(game *g)
      if (tmp->revert_to == itm_null) {
       if (inv.stack_at(i).size() == 1) {
        inv.remove_stack(i);
-       i--;
-       j = 0;
+       break;
       } else {
        inv.stack_at(i).erase(inv.stack_at(i).begin() + j);
        j--;
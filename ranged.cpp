@@ -297,7 +297,10 @@ void game::fire(player &p, int tarx, int tary, std::vector<point> &trajectory,
    int tx = trajectory[i].x, ty = trajectory[i].y;
 // If there's a monster in the path of our bullet, and either our aim was true,
 //  OR it's not the monster we were aiming at and we were lucky enough to hit it
+// A monster is tried before anyone sharing its square, so mondex comes from
+// mon_at(); creature_at() would put the player and NPCs first
    int mondex = mon_at(tx, ty);
+   creature_ref hit = creature_at(tx, ty);
 // If we shot us a monster...
    if (mondex != -1 && (!z[mondex].has_flag(MF_DIGS) ||
        rl_dist(p.posx, p.posy, z[mondex].posx, z[mondex].posy) <= 1) &&
@@ -318,15 +321,15 @@ void game::fire(player &p, int tarx, int tary, std::vector<point> &trajectory,
     shoot_monster(this, p, z[mondex], dam, goodhit, weapon);
 
    } else if ((!missed || one_in(3)) &&
-              (npc_at(tx, ty) != -1 || (u.posx == tx && u.posy == ty)))  {
+              (hit.type == CREATURE_NPC || hit.type == CREATURE_PLAYER))  {
     double goodhit = missed_by;
     if (i < trajectory.size() - 1) // Unintentional hit
      goodhit = double(rand() / (RAND_MAX + 1.0)) / 2;
     player *h;
-    if (u.posx == tx && u.posy == ty)
+    if (hit.type == CREATURE_PLAYER)
      h = &u;
     else
-     h = &(active_npc[npc_at(tx, ty)]);
+     h = &(active_npc[hit.index]);
 
     std::vector<point> blood_traj = trajectory;
     blood_traj.insert(blood_traj.begin(), point(p.posx, p.posy));
@@ -512,11 +515,11 @@ void game::throw_item(player &p, int tarx, int tary, item &thrown,
 }
 
 std::vector<point> game::target(int &x, int &y, int lowx, int lowy, int hix,
-                                int hiy, std::vector <monster> t, int &target,
+                                int hiy, const std::vector<int> &t, int &target,
                                 item *relevent)
 {
  std::vector<point> ret;
- int tarx, tary, tart, junk;
+ int tarx, tary, tart;
  // TODO: [lightmap] Enable auto targeting based on lightmap
  int sight_dist = u.sight_range(light_level());
 
@@ -528,15 +531,15 @@ std::vector<point> game::target(int &x, int &y, int lowx, int lowy, int hix,
    double closest = -1;
    double dist;
    for (int i = 0; i < t.size(); i++) {
-    dist = rl_dist(t[i].posx, t[i].posy, u.posx, u.posy);
+    dist = rl_dist(z[t[i]].posx, z[t[i]].posy, u.posx, u.posy);
     if (closest < 0 || dist < closest) {
      closest = dist;
      target = i;
     }
    }
   }
-  x = t[target].posx;
-  y = t[target].posy;
+  x = z[t[target]].posx;
+  y = z[t[target]].posy;
  } else
   target = -1;	// No monsters in range, don't use target, reset to -1
 
@@ -646,7 +649,7 @@ std::vector<point> game::target(int &x, int &y, int lowx, int lowy, int hix,
     z[mondex].draw(w_terrain, center.x, center.y, false);
    else if (npcdex != -1)
     active_npc[npcdex].draw(w_terrain, center.x, center.y, false);
-   else if (m.sees(u.posx, u.posy, x, y, -1, junk))
+   else if (m.pl_sees(u.posx, u.posy, x, y, -1))
     m.drawsq(w_terrain, u, x, y, false, true, center.x, center.y);
    else
     mvwputch(w_terrain, SEEY, SEEX, c_black, 'X');
@@ -663,16 +666,16 @@ std::vector<point> game::target(int &x, int &y, int lowx, int lowy, int hix,
   } else if ((ch == '<') && (target != -1)) {
    target--;
    if (target == -1) target = t.size() - 1;
-   x = t[target].posx;
-   y = t[target].posy;
+   x = z[t[target]].posx;
+   y = z[t[target]].posy;
   } else if ((ch == '>') && (target != -1)) {
    target++;
    if (target == t.size()) target = 0;
-   x = t[target].posx;
-   y = t[target].posy;
+   x = z[t[target]].posx;
+   y = z[t[target]].posy;
   } else if (ch == '.' || ch == 'f' || ch == 'F' || ch == '\n') {
    for (int i = 0; i < t.size(); i++) {
-    if (t[i].posx == x && t[i].posy == y)
+    if (z[t[i]].posx == x && z[t[i]].posy == y)
      target = i;
    }
    return ret;
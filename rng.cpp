@@ -20,3 +20,84 @@ int dice(int number, int sides)
   ret += rng(1, sides);
  return ret;
 }
+
+unsigned int rng_stream::game_seed = 0;
+
+rng_stream::rng_stream(int a, int b, int c, int d)
+{
+ state = (unsigned int)a * 73856093u ^ (unsigned int)b * 19349663u ^
+         (unsigned int)c * 83492791u ^ (unsigned int)d * 50331653u ^
+         game_seed * 2654435761u;
+ if (state == 0) // xorshift never leaves 0
+  state = 2463534242u;
+ for (int i = 0; i < 4; i++) // Nearby seeds start out close together
+  rng(0, 0);
+}
+
+// xorshift32
+long rng_stream::rng(long low, long high)
+{
+ state ^= state << 13;
+ state ^= state >> 17;
+ state ^= state << 5;
+ return low + long((high - low + 1) * (state / 4294967296.0));
+}
+
+bool rng_stream::one_in(int chance)
+{
+ return (chance <= 1 || rng(0, chance - 1) == 0);
+}
+
+int rng_stream::dice(int number, int sides)
+{
+ int ret = 0;
+ for (int i = 0; i < number; i++)
+  ret += rng(1, sides);
+ return ret;
+}
+
+alias_table::alias_table() : sum(0)
+{
+}
+
+// Each of the n columns holds sum's worth of weight, split between at most two
+// indices.  Weights are scaled by n instead of being turned into fractions, so
+// every index keeps exactly its share.
+alias_table::alias_table(const std::vector<int> &weights) : sum(0)
+{
+ const int n = weights.size();
+ for (int i = 0; i < n; i++)
+  sum += weights[i];
+ cut.resize(n, sum);
+ alias.resize(n);
+ std::vector<long> scaled(n);
+ std::vector<int> small, large;
+ for (int i = 0; i < n; i++) {
+  alias[i] = i;
+  scaled[i] = long(weights[i]) * n;
+  if (scaled[i] < sum)
+   small.push_back(i);
+  else
+   large.push_back(i);
+ }
+ while (!small.empty() && !large.empty()) {
+  const int s = small.back(), l = large.back();
+  small.pop_back();
+  cut[s] = scaled[s];
+  alias[s] = l;
+  scaled[l] -= sum - scaled[s];
+  if (scaled[l] < sum) {
+   large.pop_back();
+   small.push_back(l);
+  }
+ }
+}
+
+int alias_table::pick() const
+{
+ if (sum <= 0)
+  return -1;
+ const long r = ::rng(0, long(sum) * cut.size() - 1);
+ const int col = r / sum;
+ return (r % sum < cut[col] ? col : alias[col]);
+}
@@ -1,7 +1,40 @@
 #ifndef _RNG_H_
 #define _RNG_H_
 #include <stdlib.h>
+#include <vector>
 long rng(long low, long high);
 bool one_in(int chance);
 int dice(int number, int sides);
+
+// A generator with its own state, for code whose results mustn't depend on
+// the order it runs in, or shift everything drawn from rand() after it.
+// Seed it from whatever identifies the caller; game_seed is mixed in too, so
+// that the same turn and caller don't roll the same in every game.
+class rng_stream
+{
+ public:
+  rng_stream(int a, int b = 0, int c = 0, int d = 0);
+  long rng(long low, long high);
+  bool one_in(int chance);
+  int dice(int number, int sides);
+  static unsigned int game_seed; // Picked for a new game, kept in its save
+ private:
+  unsigned int state;
+};
+
+// Walker's alias method: built once from a list of weights, it then picks an
+// index with chance weight / total in O(1), using a single rng() call.
+class alias_table
+{
+ public:
+  alias_table();
+  alias_table(const std::vector<int> &weights);
+  int size() const { return cut.size(); }
+  int total() const { return sum; }
+  int pick() const; // -1 if all the weights are 0
+ private:
+  std::vector<int> cut;   // Below this (out of sum) a column picks itself...
+  std::vector<int> alias; // ...otherwise it picks this
+  int sum;
+};
 #endif
@@ -0,0 +1,51 @@
+#include "scent.h"
+#include <algorithm>
+
+void scent_terrain::set(int x, int y, bool passable, bool bashable,
+                        int slime_density)
+{
+ spreads[x][y] = (passable || bashable ? -1 : 0);
+ shift[x][y] = (passable ? 0 : 2);
+ slime[x][y] = 10 * slime_density;
+}
+
+// Each square that scent can pass takes the average of itself and its
+// neighbors at least as strong, counting itself twice; slime keeps its square
+// at 10 per density, and barriers that can only be bashed keep a quarter.
+// Squares scent can't pass are cleared.
+//
+// Only src is read and only dst is written, so rectangles spread in the same
+// turn don't see each other's results, and can be spread in any order or at
+// the same time.  The inner loop has no branches on scent, so that it can be
+// unrolled and vectorized.  tests/scent_test checks it against the plain
+// version on recorded grids.
+int diffuse_scent_rows(const short src[][SCENTMAP_Y], short dst[][SCENTMAP_Y],
+                       const scent_terrain &ter,
+                       int x1, int y1, int x2, int y2)
+{
+ int wacky = 0;
+ for (int x = x1; x <= x2; x++) {
+  const short *above = src[x - 1], *here = src[x], *below = src[x + 1];
+  const int *spreads = ter.spreads[x], *slime = ter.slime[x];
+  const int *shift = ter.shift[x];
+  for (int y = y1; y <= y2; y++) {
+   const int c = here[y];
+   int sum = 0, used = 0;
+   for (int j = -1; j <= 1; j++) {
+    // No scent is negative, so a mask of 0 or -1 picks the stronger ones
+    const int ma = -(c <= above[y + j]), mh = -(c <= here[y + j]),
+              mb = -(c <= below[y + j]);
+    sum += (above[y + j] & ma) + (here[y + j] & mh) + (below[y + j] & mb);
+    used -= ma + mh + mb;
+   }
+   int result = std::max(sum / (used + 1), slime[y]) & spreads[y];
+   if (result > 10000) {
+    wacky++;
+    result = 0; // Scent should never be higher
+   }
+   //Greatly reduce scent for bashable barriers
+   dst[x][y] = result >> shift[y];
+  }
+ }
+ return wacky;
+}
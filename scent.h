@@ -0,0 +1,36 @@
+#ifndef _SCENT_H_
+#define _SCENT_H_
+
+#include "mapdata.h"
+#include "map.h"
+
+#define SCENTMAP_X (SEEX * MAPSIZE)
+#define SCENTMAP_Y (SEEY * MAPSIZE)
+
+// What each square does to scent spreading through it, gathered from the map
+// by game::diffuse_scent() so that diffuse_scent_rows() doesn't need one
+struct scent_terrain {
+ int spreads[SCENTMAP_X][SCENTMAP_Y]; // -1 if scent passes, else 0
+ int shift[SCENTMAP_X][SCENTMAP_Y];   // 2 for bashable barriers
+ int slime[SCENTMAP_X][SCENTMAP_Y];   // 10 per density of slime
+
+ void set(int x, int y, bool passable, bool bashable, int slime_density);
+};
+
+// One turn's spread of the scent in src over the rectangle from (x1, y1) to
+// (x2, y2), written to dst.  The rectangle must not touch the edge of the
+// map, and src and dst must be different grids.  Returns how many squares
+// ended up with wacky scent, which is cleared.
+int diffuse_scent_rows(const short src[][SCENTMAP_Y], short dst[][SCENTMAP_Y],
+                       const scent_terrain &ter,
+                       int x1, int y1, int x2, int y2);
+
+// A rectangle of the map that update_scent() spreads scent over this turn
+struct scent_rect {
+ int x1, y1, x2, y2;
+ int wacky; // Set by game::diffuse_scent()
+ scent_rect(int X1, int Y1, int X2, int Y2)
+  : x1 (X1), y1 (Y1), x2 (X2), y2 (Y2), wacky (0) {};
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "soundmap.h"
+#include "map.h"
+#include <cstring>
+
+sound_map::sound_map()
+{
+ memset(level, 0, sizeof(level));
+ memset(source, 0, sizeof(source));
+}
+
+void sound_map::add(int x, int y, int vol)
+{
+ if (vol > 0)
+  events.push_back(sound_event(x, y, vol));
+}
+
+void sound_map::shift(int dx, int dy)
+{
+ for (int i = 0; i < events.size(); i++) {
+  events[i].x -= dx;
+  events[i].y -= dy;
+ }
+}
+
+// Only the terrain matters; vehicles and smoke don't muffle anything
+int sound_map::loss(map &m, int x, int y) const
+{
+ const ter_t &t = terlist[m.ter(x, y)];
+ if (t.movecost > 0 || (t.flags & mfb(transparent)))
+  return SOUND_LOSS_OPEN;
+ if (t.flags & (mfb(door) | mfb(bashable)))
+  return SOUND_LOSS_DOOR;
+ return SOUND_LOSS_WALL;
+}
+
+// A flood fill from all of the turn's sounds at once, loudest squares first.
+// Squares are bucketed by volume, so each one is settled the first time it's
+// popped at its final volume and the work done is the area that can hear
+// something, however many sounds there were.
+void sound_map::propagate(map &m, bool good_hearing)
+{
+ if (events.empty())
+  return;
+ fill(m, 0);
+ if (good_hearing)
+  fill(m, 1);
+ stats.turns++;
+ stats.events += events.size();
+}
+
+void sound_map::fill(map &m, int hearing)
+{
+ short (*lev)[SOUNDMAP_Y] = level[hearing];
+ short (*src)[SOUNDMAP_Y] = source[hearing];
+ const int scale = hearing + 1;
+ int loudest = 0;
+ for (int i = 0; i < events.size(); i++) {
+  if (events[i].volume * scale > loudest)
+   loudest = events[i].volume * scale;
+ }
+ std::vector< std::vector<point> > buckets(loudest + 1);
+ for (int i = 0; i < events.size(); i++) {
+  const sound_event &ev = events[i];
+  const int start = ev.volume * scale;
+  if (ev.x < 0 || ev.x >= SOUNDMAP_X || ev.y < 0 || ev.y >= SOUNDMAP_Y ||
+      start <= lev[ev.x][ev.y])
+   continue;
+  if (lev[ev.x][ev.y] == 0)
+   reached[hearing].push_back(point(ev.x, ev.y));
+  lev[ev.x][ev.y] = start;
+  src[ev.x][ev.y] = i;
+  buckets[start].push_back(point(ev.x, ev.y));
+ }
+
+ for (int v = loudest; v > 0; v--) {
+  // Quiet squares can be added to a lower bucket while we're in this one,
+  // but never to this one, so it's safe to walk it by index.
+  for (int n = 0; n < buckets[v].size(); n++) {
+   const int x = buckets[v][n].x, y = buckets[v][n].y;
+   if (lev[x][y] != v)
+    continue; // Something louder got here after this was queued
+   for (int nx = x - 1; nx <= x + 1; nx++) {
+    for (int ny = y - 1; ny <= y + 1; ny++) {
+     if (nx < 0 || nx >= SOUNDMAP_X || ny < 0 || ny >= SOUNDMAP_Y)
+      continue;
+     const int heard = v - loss(m, nx, ny);
+     if (heard <= lev[nx][ny])
+      continue;
+     if (lev[nx][ny] == 0)
+      reached[hearing].push_back(point(nx, ny));
+     lev[nx][ny] = heard;
+     src[nx][ny] = src[x][y];
+     buckets[heard].push_back(point(nx, ny));
+    }
+   }
+  }
+  std::vector<point>().swap(buckets[v]);
+ }
+ stats.squares += reached[hearing].size();
+}
+
+// Good hearing hears a sound of volume V that has lost L on its way as
+// V - L / 2, as game::sound() worked it out from the distance
+int sound_map::volume_at(int x, int y, bool good_hearing) const
+{
+ if (x < 0 || x >= SOUNDMAP_X || y < 0 || y >= SOUNDMAP_Y)
+  return 0;
+ if (!good_hearing)
+  return level[0][x][y];
+ if (level[1][x][y] <= 0)
+  return 0;
+ const int vol = events[source[1][x][y]].volume;
+ return vol - (vol * 2 - level[1][x][y]) / 2;
+}
+
+const sound_event &sound_map::source_at(int x, int y, bool good_hearing) const
+{
+ return events[source[good_hearing ? 1 : 0][x][y]];
+}
+
+void sound_map::clear()
+{
+ for (int h = 0; h < 2; h++) {
+  for (int i = 0; i < reached[h].size(); i++) {
+   level[h][reached[h][i].x][reached[h][i].y] = 0;
+   source[h][reached[h][i].x][reached[h][i].y] = 0;
+  }
+  reached[h].clear();
+ }
+ events.clear();
+}
@@ -0,0 +1,70 @@
+#ifndef _SOUNDMAP_H_
+#define _SOUNDMAP_H_
+
+#include "mapdata.h"
+#include "map.h"
+#include "enums.h"
+#include <vector>
+
+// Volume lost stepping into a square, by what's in it
+#define SOUND_LOSS_OPEN  1  // Anything passable or see-through
+#define SOUND_LOSS_DOOR  4  // Closed doors, boarded windows, thin walls
+#define SOUND_LOSS_WALL 12  // Solid walls
+
+#define SOUNDMAP_X (SEEX * MAPSIZE)
+#define SOUNDMAP_Y (SEEY * MAPSIZE)
+
+struct sound_event {
+ int x, y;
+ int volume;
+ sound_event(int px, int py, int vol) : x(px), y(py), volume(vol) {}
+};
+
+struct sound_map_stats {
+ int turns;   // propagate() calls that had sounds to spread
+ int events;  // Sounds spread
+ int squares; // Squares reached, summed over turns
+ sound_map_stats() : turns(0), events(0), squares(0) {}
+};
+
+// Collects the sounds made since they were last heard and spreads them over
+// the map all at once, so that monsters can look up what they hear at their
+// own square instead of every sound being checked against every monster.
+// Sounds fade by SOUND_LOSS_OPEN per square (the same roguelike distance
+// game::sound() used to subtract) and faster through doors and walls; where
+// several overlap, the loudest wins.  Monsters with good hearing lose only
+// half as much, so they get a spread of their own that reaches further.
+class sound_map
+{
+ public:
+  sound_map();
+
+  void add(int x, int y, int volume);
+  bool empty() const { return events.empty(); }
+  // Moves the queued sounds along with the map when it shifts
+  void shift(int dx, int dy);
+
+  // Spreads the queued sounds out over m; for good hearing too if asked
+  void propagate(map &m, bool good_hearing);
+  // How loud it is at (x, y) after propagate(), 0 if silent
+  int volume_at(int x, int y, bool good_hearing = false) const;
+  // Where the sound heard at (x, y) came from, and how loud it was there
+  const sound_event &source_at(int x, int y, bool good_hearing = false) const;
+  // Forgets this turn's sounds
+  void clear();
+
+  sound_map_stats stats;
+
+ private:
+  int loss(map &m, int x, int y) const;
+  void fill(map &m, int hearing);
+
+  std::vector<sound_event> events;
+// [0] is ordinary hearing.  [1] is good hearing, kept at twice the volume so
+// that it loses half a point per point of loss.
+  short level[2][SOUNDMAP_X][SOUNDMAP_Y];
+  short source[2][SOUNDMAP_X][SOUNDMAP_Y]; // Index into events
+  std::vector<point> reached[2];           // Squares to reset in clear()
+};
+
+#endif
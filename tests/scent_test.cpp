@@ -0,0 +1,226 @@
+// Runs diffuse_scent_rows() over recorded scent grids and checks that it
+// gives exactly the expected scent, square for square.
+//
+// A grid file holds, after any # comment lines:
+//  turns N          how many turns to spread for
+//  player X Y S     the player lays down scent S at (X, Y) before each turn
+//  area X1 Y1 X2 Y2 the rectangle spread over each turn
+//  scent            then SCENTMAP_Y rows of SCENTMAP_X numbers
+//  terrain          then SCENTMAP_Y rows of SCENTMAP_X characters:
+//                    . passable, + bashable barrier, # wall,
+//                    1-3 passable with that density of slime
+//  expected         then SCENTMAP_Y rows of SCENTMAP_X numbers
+//
+// scent_test --record FILE prints FILE with its expected scent worked out by
+// the plain version of the spread below, for making new grids.
+
+#include "scent.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct scent_case {
+ int turns;
+ int px, py, pscent;
+ int x1, y1, x2, y2;
+ short scent[SCENTMAP_X][SCENTMAP_Y];
+ char terrain[SCENTMAP_X][SCENTMAP_Y];
+ short expected[SCENTMAP_X][SCENTMAP_Y];
+ bool has_expected;
+};
+
+static bool read_grid(std::istream &fin, short grid[][SCENTMAP_Y])
+{
+ for (int y = 0; y < SCENTMAP_Y; y++) {
+  for (int x = 0; x < SCENTMAP_X; x++) {
+   if (!(fin >> grid[x][y]))
+    return false;
+  }
+ }
+ return true;
+}
+
+static bool load_case(const char *path, scent_case &c)
+{
+ std::ifstream fin(path);
+ if (!fin)
+  return false;
+ bool got_scent = false, got_terrain = false;
+ c.has_expected = false;
+ std::string word;
+ while (fin >> word) {
+  if (word[0] == '#')
+   std::getline(fin, word);
+  else if (word == "turns")
+   fin >> c.turns;
+  else if (word == "player")
+   fin >> c.px >> c.py >> c.pscent;
+  else if (word == "area")
+   fin >> c.x1 >> c.y1 >> c.x2 >> c.y2;
+  else if (word == "scent")
+   got_scent = read_grid(fin, c.scent);
+  else if (word == "expected")
+   c.has_expected = read_grid(fin, c.expected);
+  else if (word == "terrain") {
+   got_terrain = true;
+   for (int y = 0; y < SCENTMAP_Y && got_terrain; y++) {
+    std::string row;
+    fin >> row;
+    if (row.size() != SCENTMAP_X)
+     got_terrain = false;
+    for (int x = 0; x < row.size() && got_terrain; x++)
+     c.terrain[x][y] = row[x];
+   }
+  } else
+   return false;
+ }
+ return got_scent && got_terrain;
+}
+
+static bool passable(char t) { return t == '.' || (t >= '1' && t <= '3'); }
+static int slime(char t) { return (t >= '1' && t <= '3' ? t - '0' : 0); }
+
+// The spread as game::update_scent() did it before diffuse_scent_rows(), one
+// square at a time into a second grid
+static void diffuse_scent_plain(short grid[][SCENTMAP_Y], const scent_case &c)
+{
+ static int newscent[SCENTMAP_X][SCENTMAP_Y];
+ for (int x = c.x1; x <= c.x2; x++) {
+  for (int y = c.y1; y <= c.y2; y++) {
+   newscent[x][y] = 0;
+   if (passable(c.terrain[x][y]) || c.terrain[x][y] == '+') {
+    int squares_used = 0;
+    for (int i = -1; i <= 1; i++) {
+     for (int j = -1; j <= 1; j++) {
+      if (grid[x][y] <= grid[x+i][y+j]) {
+       newscent[x][y] += grid[x+i][y+j];
+       squares_used++;
+      }
+     }
+    }
+    newscent[x][y] /= (squares_used + 1);
+    if (newscent[x][y] < 10 * slime(c.terrain[x][y]))
+     newscent[x][y] = 10 * slime(c.terrain[x][y]);
+    if (newscent[x][y] > 10000)
+     newscent[x][y] = 0; // Scent should never be higher
+   }
+  }
+ }
+ for (int x = c.x1; x <= c.x2; x++) {
+  for (int y = c.y1; y <= c.y2; y++) {
+   if (!passable(c.terrain[x][y]))
+    grid[x][y] = newscent[x][y] / 4;
+   else
+    grid[x][y] = newscent[x][y];
+  }
+ }
+}
+
+static int record(const char *path, scent_case &c)
+{
+ for (int i = 0; i < c.turns; i++) {
+  c.scent[c.px][c.py] = c.pscent;
+  diffuse_scent_plain(c.scent, c);
+ }
+ std::ifstream fin(path);
+ std::string line;
+ while (std::getline(fin, line) && line != "expected")
+  std::cout << line << "\n";
+ std::cout << "expected\n";
+ for (int y = 0; y < SCENTMAP_Y; y++) {
+  for (int x = 0; x < SCENTMAP_X; x++)
+   std::cout << c.scent[x][y] << (x + 1 < SCENTMAP_X ? " " : "\n");
+ }
+ return 0;
+}
+
+struct column_run {
+ const scent_terrain *ter;
+ short (*src)[SCENTMAP_Y];
+ short (*dst)[SCENTMAP_Y];
+ std::vector<scent_rect> rects;
+};
+
+static void spread_column(void *data, int index)
+{
+ column_run *run = (column_run *)data;
+ const scent_rect &r = run->rects[index];
+ diffuse_scent_rows(run->src, run->dst, *run->ter, r.x1, r.y1, r.x2, r.y2);
+}
+
+// Spreads the case's area whole, or, if columns is set, a submap column at a
+// time on the worker pool, the way game::update_scent() splits it.  Both read
+// only the start of the turn, so they must agree with each other and with
+// the expected scent.
+static bool check(const char *path, const scent_case &c, bool columns)
+{
+ static short grid[SCENTMAP_X][SCENTMAP_Y], old[SCENTMAP_X][SCENTMAP_Y];
+ static scent_terrain ter;
+ for (int x = 0; x < SCENTMAP_X; x++) {
+  for (int y = 0; y < SCENTMAP_Y; y++) {
+   grid[x][y] = c.scent[x][y];
+   ter.set(x, y, passable(c.terrain[x][y]), c.terrain[x][y] == '+',
+           slime(c.terrain[x][y]));
+  }
+ }
+ for (int i = 0; i < c.turns; i++) {
+  grid[c.px][c.py] = c.pscent;
+  memcpy(old, grid, sizeof(grid));
+  if (!columns)
+   diffuse_scent_rows(old, grid, ter, c.x1, c.y1, c.x2, c.y2);
+  else {
+   column_run run = { &ter, old, grid, std::vector<scent_rect>() };
+   for (int x = c.x1; x <= c.x2; x = (x / SEEX + 1) * SEEX)
+    run.rects.push_back(scent_rect(x, c.y1,
+                                   std::min((x / SEEX + 1) * SEEX - 1, c.x2),
+                                   c.y2));
+   run_jobs(spread_column, &run, run.rects.size());
+  }
+ }
+ int differ = 0;
+ for (int x = 0; x < SCENTMAP_X; x++) {
+  for (int y = 0; y < SCENTMAP_Y; y++) {
+   if (grid[x][y] != c.expected[x][y]) {
+    if (differ < 10)
+     std::cout << path << ": " << x << "," << y << " is " << grid[x][y]
+               << ", expected " << c.expected[x][y] << "\n";
+    differ++;
+   }
+  }
+ }
+ std::cout << path << (columns ? " in columns: " : ": ")
+           << (differ == 0 ? "ok" : "FAILED") << ", " << differ
+           << " squares differ after " << c.turns << " turns\n";
+ return differ == 0;
+}
+
+int main(int argc, char *argv[])
+{
+ static scent_case c;
+ if (argc == 3 && std::string(argv[1]) == "--record") {
+  if (!load_case(argv[2], c)) {
+   std::cerr << "Can't read " << argv[2] << "\n";
+   return 1;
+  }
+  return record(argv[2], c);
+ }
+ if (argc < 2) {
+  std::cerr << "Usage: " << argv[0] << " [--record] GRID...\n";
+  return 1;
+ }
+ bool ok = true;
+ for (int i = 1; i < argc; i++) {
+  if (!load_case(argv[i], c) || !c.has_expected) {
+   std::cout << argv[i] << ": can't read the grid\n";
+   ok = false;
+  } else {
+   ok &= check(argv[i], c, false);
+   ok &= check(argv[i], c, true);
+  }
+ }
+ return (ok ? 0 : 1);
+}
@@ -0,0 +1,114 @@
+#include "threadpool.h"
+
+#ifdef THREADS
+
+#include <pthread.h>
+#include <unistd.h>
+
+#define MAX_POOL_THREADS 16
+
+// Everything below is guarded by pool_lock.  A run hands out job indices one
+// at a time; workers wake when run_number changes.
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done = PTHREAD_COND_INITIALIZER;
+static pool_job run_job = 0;
+static void *run_data = 0;
+static int run_count = 0, run_next = 0, run_finished = 0;
+static int run_number = 0;
+static int workers = -1; // -1 until the pool is started
+
+// Does jobs from the current run until there are none left to hand out.
+// Called and returns with pool_lock held.
+static void work_on_run()
+{
+ while (run_next < run_count) {
+  const int index = run_next++;
+  pool_job job = run_job;
+  void *data = run_data;
+  pthread_mutex_unlock(&pool_lock);
+  job(data, index);
+  pthread_mutex_lock(&pool_lock);
+  if (++run_finished == run_count)
+   pthread_cond_signal(&pool_done);
+ }
+}
+
+static void *worker_main(void *)
+{
+ pthread_mutex_lock(&pool_lock);
+ int last_run = run_number;
+ while (true) {
+  while (run_number == last_run)
+   pthread_cond_wait(&pool_wake, &pool_lock);
+  last_run = run_number;
+  work_on_run();
+ }
+ return 0;
+}
+
+static void start_pool()
+{
+ long cores = sysconf(_SC_NPROCESSORS_ONLN);
+ if (cores > MAX_POOL_THREADS)
+  cores = MAX_POOL_THREADS;
+ workers = 0;
+ for (int i = 1; i < cores; i++) {
+  pthread_t thread;
+  if (pthread_create(&thread, 0, worker_main, 0) != 0)
+   break;
+  pthread_detach(thread);
+  workers++;
+ }
+}
+
+void run_jobs(pool_job job, void *data, int count)
+{
+ if (count <= 0)
+  return;
+ pthread_mutex_lock(&pool_lock);
+ if (workers < 0)
+  start_pool();
+ if (workers == 0 || count == 1) {
+  pthread_mutex_unlock(&pool_lock);
+  for (int i = 0; i < count; i++)
+   job(data, i);
+  return;
+ }
+ run_job = job;
+ run_data = data;
+ run_count = count;
+ run_next = 0;
+ run_finished = 0;
+ run_number++;
+ pthread_cond_broadcast(&pool_wake);
+ work_on_run();
+ while (run_finished < run_count)
+  pthread_cond_wait(&pool_done, &pool_lock);
+ pthread_mutex_unlock(&pool_lock);
+}
+
+int pool_threads()
+{
+ pthread_mutex_lock(&pool_lock);
+ if (workers < 0)
+  start_pool();
+ const int ret = workers + 1;
+ pthread_mutex_unlock(&pool_lock);
+ return ret;
+}
+
+#else
+
+void run_jobs(pool_job job, void *data, int count)
+{
+ for (int i = 0; i < count; i++)
+  job(data, i);
+}
+
+int pool_threads()
+{
+ return 1;
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+// Runs job(data, 0) ... job(data, count - 1) and returns once they're all
+// done.  Built with THREADS=1 (see the Makefile), the jobs are shared out
+// between the calling thread and a pool of worker threads, one per extra
+// core; otherwise they run one after another on the calling thread.
+//
+// Jobs must not write anything another job in the same run reads or writes,
+// and must not draw from the game's rng or touch curses.  Then the result
+// is the same however many threads there are, and in whatever order the
+// jobs finish.
+typedef void (*pool_job)(void *data, int index);
+void run_jobs(pool_job job, void *data, int count);
+
+// How many threads run_jobs() shares work between, counting the caller
+int pool_threads();
+
+#endif
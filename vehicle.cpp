@@ -1801,15 +1801,14 @@ bool vehicle::fire_turret_internal (int p, it_gun &gun, it_ammo &ammo, int charg
     int t, fire_t;
     monster *target = 0;
     int range = ammo.type == AT_GAS? 5 : 12;
-    int closest = range + 1;
-    for (int i = 0; i < g->z.size(); i++)
+    std::vector<int> nearby = g->nearest_mons(x, y, range);
+    for (int n = 0; n < nearby.size() && !target; n++)
     {
-        int dist = rl_dist(x, y, g->z[i].posx, g->z[i].posy);
-        if (g->z[i].friendly == 0 && dist < closest &&
-            g->m.sees(x, y, g->z[i].posx, g->z[i].posy, range, t))
+        monster *mon = &(g->z[nearby[n]]);
+        if (mon->friendly == 0 &&
+            g->m.sees(x, y, mon->posx, mon->posy, range, t))
         {
-            target = &(g->z[i]);
-            closest = dist;
+            target = mon;
             fire_t = t;
         }
     }